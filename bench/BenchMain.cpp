@@ -0,0 +1,117 @@
+#include <cstring>
+
+#include "AllocTracker.hpp"
+#include "Trace.hpp"
+
+#include <exception>
+#include <iostream>
+#include <string>
+
+// Benchmark subcommands, one per translation unit.
+int runCodecBench(int argc, char **argv);
+int runMoneyBench(int argc, char **argv);
+int runPipelineBench(int argc, char **argv);
+int runPrecisionBench(int argc, char **argv);
+int runSweepBench(int argc, char **argv);
+
+namespace
+{
+
+struct BenchEntry
+{
+  const char *name;
+  const char *description;
+  int (*run)(int, char **);
+};
+
+const BenchEntry benches[] = {
+  { "pipeline", "serial vs pipelined engine on a heavy synthetic strategy", runPipelineBench },
+  { "sweep", "many small backtests: heap allocation vs per-worker run arenas", runSweepBench },
+  { "codec", "columnar codec: compression ratio, decode speed, packed vs raw reads",
+    runCodecBench },
+  { "precision", "float32 vs float64 bar storage: Report accuracy and streaming speed",
+    runPrecisionBench },
+  { "money", "fill-heavy run and fill ordering with this build's money type", runMoneyBench },
+};
+
+void usage()
+{
+  std::cerr << "usage: backtest_bench [--alloc-report | --alloc-strict] [--trace <file>] "
+               "<name> [args...]\n\n"
+               "  --alloc-report  print heap allocations per engine phase afterwards\n"
+               "  --alloc-strict  also abort on any allocation in a steady-state bar loop\n"
+               "                  (both need a -DBACKTEST_ALLOC_TRACKING=ON build)\n"
+               "  --trace <file>  write a Chrome trace of the benchmark to <file>\n\n"
+               "available benchmarks:\n";
+  for(const auto &b : benches)
+  {
+    std::cerr << "  " << b.name << "  " << b.description << "\n";
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+  bool reportAllocs = false;
+  const char *tracePath = nullptr;
+  int first = 1;
+  for(; first < argc && std::strncmp(argv[first], "--", 2) == 0; ++first)
+  {
+    if(std::strcmp(argv[first], "--trace") == 0 && first + 1 < argc)
+    {
+      tracePath = argv[++first];
+      Trace::enable();
+      Trace::setThreadName("main");
+    }
+    else if(std::strncmp(argv[first], "--alloc-", 8) == 0)
+    {
+      reportAllocs = true;
+      AllocTracker::setStrict(std::strcmp(argv[first], "--alloc-strict") == 0);
+    }
+    else
+    {
+      usage();
+      return 1;
+    }
+  }
+
+  if(argc - first < 1)
+  {
+    usage();
+    return 1;
+  }
+  if(reportAllocs && !AllocTracker::enabled)
+  {
+    std::cerr << "WARNING: built without BACKTEST_ALLOC_TRACKING; no allocations are counted\n";
+  }
+
+  try
+  {
+    for(const auto &b : benches)
+    {
+      if(std::strcmp(argv[first], b.name) == 0)
+      {
+        int rc = b.run(argc - first - 1, argv + first + 1);
+        if(tracePath != nullptr)
+        {
+          Trace::writeChromeTrace(tracePath);
+        }
+        if(reportAllocs)
+        {
+          std::cout << "heap allocations (all threads):\n";
+          writeAllocReport(std::cout, AllocTracker::processStats());
+        }
+        return rc;
+      }
+    }
+  }
+  catch(const std::exception &ex)
+  {
+    std::cerr << "ERROR: " << ex.what() << "\n";
+    return 1;
+  }
+
+  usage();
+  return 1;
+}
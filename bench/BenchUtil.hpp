@@ -0,0 +1,58 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Timestamp.hpp"
+#include "TradingTypes.hpp"
+
+// Shared helpers for the benchmark subcommands.
+
+// Geometric random walk with one bar per calendar day from 2000-01-01.
+inline std::vector<Candle> makeSyntheticCandles(const std::string &symbol,
+                                                std::size_t bars,
+                                                std::uint64_t seed = 1)
+{
+  std::mt19937_64 rng(seed);
+  std::normal_distribution<double> ret(0.0002, 0.01);
+
+  std::vector<Candle> out;
+  out.reserve(bars);
+
+  const std::int64_t start = parseTimestamp("2000-01-01");
+  double price = 100.0;
+  for(std::size_t i = 0; i < bars; ++i)
+  {
+    Candle c;
+    c.timestamp = formatTimestamp(start + static_cast<std::int64_t>(i) * 86400);
+    c.symbol = symbol;
+    c.open = price;
+    price *= 1.0 + ret(rng);
+    c.close = price;
+    c.high = std::max(c.open, c.close) * 1.004;
+    c.low = std::min(c.open, c.close) * 0.996;
+    c.volume = 1.0e6 + static_cast<double>(rng() % 100000);
+    out.push_back(std::move(c));
+  }
+  return out;
+}
+
+class BenchTimer
+{
+public:
+  BenchTimer()
+    : start_(std::chrono::steady_clock::now()) {}
+
+  double seconds() const
+  {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+  }
+
+private:
+  std::chrono::steady_clock::time_point start_;
+};
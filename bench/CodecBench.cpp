@@ -0,0 +1,176 @@
+#include "BenchUtil.hpp"
+#include "ColumnCodec.hpp"
+#include "ColumnarStore.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <unistd.h>
+
+namespace
+{
+
+// Minute bars quoted in cents with volumes in round lots, the shape of
+// real intraday data (synthetic daily candles have full-precision prices,
+// which the codec would store raw).
+BarColumns makeMinuteBars(std::size_t bars)
+{
+  std::mt19937_64 rng(7);
+  std::normal_distribution<double> step(0.0, 4.0); // cents per minute
+
+  BarColumns out;
+  out.symbol = "SYN";
+  std::int64_t time = parseTimestamp("2015-01-02 09:30:00");
+  double cents = 10000.0;
+  for(std::size_t i = 0; i < bars; ++i)
+  {
+    if(i % 390 == 0 && i > 0)
+    {
+      time += 86400 - 390 * 60; // next session
+    }
+    time += 60;
+
+    const double open = cents;
+    cents = std::max(100.0, cents + std::round(step(rng)));
+    const double hi = std::max(open, cents) + static_cast<double>(rng() % 5);
+    const double lo = std::min(open, cents) - static_cast<double>(rng() % 5);
+    out.time.push_back(time);
+    out.open.push_back(open / 100.0);
+    out.high.push_back(hi / 100.0);
+    out.low.push_back(lo / 100.0);
+    out.close.push_back(cents / 100.0);
+    out.volume.push_back(static_cast<double>(100 * (1 + rng() % 50)));
+  }
+  return out;
+}
+
+double readSeconds(const std::string &path, const std::string &symbol, std::size_t repeats)
+{
+  ColumnarShardReader reader(path);
+  BenchTimer timer;
+  for(std::size_t r = 0; r < repeats; ++r)
+  {
+    BarColumns bars = reader.read(symbol);
+    if(bars.size() == 0)
+    {
+      throw std::runtime_error("empty read");
+    }
+  }
+  return timer.seconds() / static_cast<double>(repeats);
+}
+
+} // namespace
+
+// Compression ratio and decode speed of the columnar codec, and full
+// shard reads (from the page cache) packed vs raw.
+int runCodecBench(int argc, char **argv)
+{
+  const std::size_t bars = argc > 0 ? std::stoul(argv[0]) : 2000000;
+  const std::size_t repeats = argc > 1 ? std::stoul(argv[1]) : 5;
+  const std::size_t rows = ColumnarShardWriter::defaultChunkRows;
+
+  BarColumns data = makeMinuteBars(bars);
+  const char *names[] = { "time", "open", "high", "low", "close", "volume" };
+  const std::vector<double> *prices[] = { &data.open, &data.high, &data.low, &data.close,
+                                          &data.volume };
+
+  std::cout << "bars:              " << bars << " (chunks of " << rows << ")\n";
+  bool lossless = true;
+  std::size_t rawTotal = 0;
+  std::size_t packedTotal = 0;
+  double decodeTotal = 0.0;
+  std::vector<std::uint8_t> blocks;
+  std::vector<std::size_t> sizes;
+  for(std::size_t c = 0; c < 6; ++c)
+  {
+    // Encode chunk by chunk, as the shard writer does.
+    blocks.clear();
+    sizes.clear();
+    for(std::size_t first = 0; first < bars; first += rows)
+    {
+      const std::size_t n = std::min(rows, bars - first);
+      sizes.push_back(c == 0 ? encodeColumn(data.time.data() + first, n,
+                                            ColumnEncoding::Packed, blocks)
+                             : encodeColumn(prices[c - 1]->data() + first, n,
+                                            ColumnEncoding::Packed, blocks));
+    }
+
+    std::vector<double> values(bars);
+    std::vector<std::int64_t> times(bars);
+    BenchTimer timer;
+    for(std::size_t r = 0; r < repeats; ++r)
+    {
+      const std::uint8_t *block = blocks.data();
+      for(std::size_t k = 0, first = 0; first < bars; ++k, first += rows)
+      {
+        const std::size_t n = std::min(rows, bars - first);
+        if(c == 0)
+        {
+          decodeColumn(block, sizes[k], n, times.data() + first);
+        }
+        else
+        {
+          decodeColumn(block, sizes[k], n, values.data() + first);
+        }
+        block += sizes[k];
+      }
+    }
+    const double seconds = timer.seconds() / static_cast<double>(repeats);
+    lossless = lossless
+               && (c == 0 ? std::memcmp(times.data(), data.time.data(), bars * 8) == 0
+                          : std::memcmp(values.data(), prices[c - 1]->data(), bars * 8) == 0);
+
+    const std::size_t raw = bars * 8;
+    rawTotal += raw;
+    packedTotal += blocks.size();
+    decodeTotal += seconds;
+    std::cout << "  " << names[c] << ":" << std::string(8 - std::strlen(names[c]), ' ')
+              << static_cast<double>(raw) / static_cast<double>(blocks.size()) << "x, decode "
+              << static_cast<double>(raw) / seconds / 1e9 << " GB/s\n";
+  }
+  std::cout << "all columns:       "
+            << static_cast<double>(rawTotal) / static_cast<double>(packedTotal) << "x ("
+            << rawTotal / 1000000 << " MB -> " << packedTotal / 1000000 << " MB), decode "
+            << static_cast<double>(rawTotal) / decodeTotal / 1e9 << " GB/s\n";
+
+  // Whole-shard reads. Both files are in the page cache here, so the raw
+  // shard reads at memory speed; from a device, the packed shard wins
+  // whenever the device is slower than the break-even bandwidth.
+  const auto dir = std::filesystem::temp_directory_path()
+                   / ("backtest-codec-bench-" + std::to_string(::getpid()));
+  std::filesystem::create_directories(dir);
+  const std::string packedPath = (dir / "packed.cols").string();
+  const std::string rawPath = (dir / "raw.cols").string();
+  {
+    ColumnarShardWriter packed(packedPath, rows, ColumnEncoding::Packed);
+    packed.write(data);
+    packed.finish();
+    ColumnarShardWriter raw(rawPath, rows, ColumnEncoding::Raw);
+    raw.write(data);
+    raw.finish();
+  }
+  const double packedBytes = static_cast<double>(std::filesystem::file_size(packedPath));
+  const double rawBytes = static_cast<double>(std::filesystem::file_size(rawPath));
+  const double packedRead = readSeconds(packedPath, data.symbol, repeats);
+  const double rawRead = readSeconds(rawPath, data.symbol, repeats);
+  std::filesystem::remove_all(dir);
+
+  std::cout << "shard read, raw:    " << rawRead * 1e3 << " ms (" << rawBytes / 1e6 << " MB)\n"
+            << "shard read, packed: " << packedRead * 1e3 << " ms (" << packedBytes / 1e6
+            << " MB)\n";
+  if(packedRead <= rawRead)
+  {
+    // Decoding costs less than copying the extra raw bytes, even cached.
+    std::cout << "break-even device:  none (packed reads are faster at any bandwidth)\n";
+  }
+  else
+  {
+    std::cout << "break-even device:  "
+              << (rawBytes - packedBytes) / (packedRead - rawRead) / 1e9
+              << " GB/s (packed reads are faster below this)\n";
+  }
+  std::cout << "lossless:           " << (lossless ? "yes" : "NO") << "\n";
+
+  return lossless ? 0 : 1;
+}
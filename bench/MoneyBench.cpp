@@ -0,0 +1,140 @@
+#include "BacktestEngine.hpp"
+#include "BenchUtil.hpp"
+#include "Portfolio.hpp"
+#include "exec/SimpleExecutionEngine.hpp"
+#include "feed/MergedFeed.hpp"
+
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+
+// Trades every bar: adds to, reduces, closes and flips positions, so the
+// run is dominated by fills and portfolio accounting.
+class ChurnStrategy : public Strategy_I
+{
+public:
+  void onStart(BacktestEngine &) override {}
+
+  void onBar(std::size_t index, const Candle &bar, BacktestEngine &engine) override
+  {
+    const Position *pos = engine.portfolio().getPosition(bar.symbol);
+    const int qty = pos ? pos->quantity : 0;
+    const int step = 10 + static_cast<int>(index % 7) * 5;
+
+    Order o;
+    o.symbol = bar.symbol;
+    if(index % 5 < 3)
+    {
+      o.side = qty < 200 ? OrderSide::Buy : OrderSide::Sell;
+      o.quantity = step;
+    }
+    else
+    {
+      o.side = qty > 0 ? OrderSide::Sell : OrderSide::Buy;
+      o.quantity = std::abs(qty) + step;
+    }
+    engine.placeOrder(o);
+  }
+
+  void onEnd(BacktestEngine &) override {}
+};
+
+std::vector<Fill> makeFills(std::size_t count, std::size_t symbols)
+{
+  std::mt19937_64 rng(11);
+  std::vector<double> price(symbols, 50.0);
+  std::vector<Fill> fills;
+  fills.reserve(count);
+  for(std::size_t i = 0; i < count; ++i)
+  {
+    const std::size_t s = rng() % symbols;
+    price[s] = std::max(1.0, price[s] + static_cast<double>(rng() % 201) / 100.0 - 1.0);
+    Fill f;
+    f.symbol = "S" + std::to_string(s);
+    f.side = rng() % 2 ? OrderSide::Buy : OrderSide::Sell;
+    f.quantity = 1 + static_cast<int>(rng() % 300);
+    f.price = toMoney(price[s]);
+    fills.push_back(std::move(f));
+  }
+  return fills;
+}
+
+bool sameBits(double a, double b)
+{
+  return std::memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+} // namespace
+
+// usage: backtest_bench money [bars per symbol] [symbols]
+//
+// Throughput of a fill-heavy run with the Money type this build uses
+// (configure with -DBACKTEST_FIXED_POINT_MONEY=ON for int64 micro-units),
+// and whether cash and realized PnL depend on the order fills of
+// different symbols arrive in.
+int runMoneyBench(int argc, char **argv)
+{
+  const std::size_t bars = argc > 0 ? std::stoul(argv[0]) : 5000;
+  const std::size_t symbols = argc > 1 ? std::stoul(argv[1]) : 200;
+
+  std::vector<std::vector<Candle>> series;
+  for(std::size_t s = 0; s < symbols; ++s)
+  {
+    std::vector<Candle> candles = makeSyntheticCandles("S" + std::to_string(s), bars, s + 1);
+    series.push_back(std::move(candles));
+  }
+
+  auto exec = std::make_unique<SimpleExecutionEngine>();
+  exec->setDefaultTickSize(0.01);
+  BacktestEngine engine(std::make_unique<ChurnStrategy>(),
+                        std::move(exec),
+                        std::make_unique<MergedFeed>(std::move(series)),
+                        1.0e7);
+  BenchTimer runTimer;
+  Report report = engine.run();
+  const double runSeconds = runTimer.seconds();
+  const double runFills = static_cast<double>(engine.ledger().size());
+  const double totalBars = static_cast<double>(bars * symbols);
+
+  // The same fills applied in two interleavings; each symbol's own fills
+  // keep their order, so only the order of cross-symbol sums changes.
+  const std::vector<Fill> fills = makeFills(2000000, 64);
+  std::vector<Fill> bySymbol = fills;
+  std::stable_sort(bySymbol.begin(), bySymbol.end(),
+                   [](const Fill &a, const Fill &b) { return a.symbol < b.symbol; });
+
+  Portfolio interleaved(1.0e7);
+  BenchTimer fillTimer;
+  for(const auto &f : fills)
+  {
+    interleaved.applyFill(f);
+  }
+  const double fillSeconds = fillTimer.seconds();
+  Portfolio grouped(1.0e7);
+  for(const auto &f : bySymbol)
+  {
+    grouped.applyFill(f);
+  }
+  const bool independent = sameBits(interleaved.getCash(), grouped.getCash())
+                           && sameBits(interleaved.getRealizedPnL(), grouped.getRealizedPnL());
+
+  std::cout.precision(15);
+  std::cout << "money type:        "
+            << (fixedPointMoney ? "int64 micro-units (fixed point)" : "double") << "\n"
+            << "engine run:        " << bars << " bars x " << symbols << " symbols, "
+            << runSeconds << " s (" << totalBars / runSeconds / 1e6 << " M bars/s, "
+            << runFills / runSeconds / 1e6 << " M fills/s)\n"
+            << "run realized PnL:  " << report.realizedPnL << "\n"
+            << "applyFill:         " << static_cast<double>(fills.size()) / fillSeconds / 1e6
+            << " M fills/s\n"
+            << "cash:              " << interleaved.getCash() << " vs " << grouped.getCash()
+            << "\n"
+            << "realized PnL:      " << interleaved.getRealizedPnL() << " vs "
+            << grouped.getRealizedPnL() << "\n"
+            << "order-independent: " << (independent ? "yes" : "no") << "\n";
+
+  // Exactness is only promised by the fixed-point build.
+  return fixedPointMoney && !independent ? 1 : 0;
+}
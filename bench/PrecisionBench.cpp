@@ -0,0 +1,202 @@
+#include "BacktestEngine.hpp"
+#include "BarColumns.hpp"
+#include "BenchUtil.hpp"
+#include "Log.hpp"
+#include "StrategyFactory.hpp"
+#include "SweepRunner.hpp"
+#include "exec/SimpleExecutionEngine.hpp"
+#include "feed/BarColumnsFeed.hpp"
+#include "feed/CandleViewFeed.hpp"
+#include "feed/MergedFeed.hpp"
+#include "feed/UniverseFeed.hpp"
+
+#include <cmath>
+#include <iostream>
+#include <type_traits>
+
+using nlohmann::json;
+
+namespace
+{
+
+constexpr double initialCash = 100000.0;
+
+struct RunOutcome
+{
+  Report report;
+  std::size_t trades{};
+};
+
+// Largest metric differences between the float64 and float32 runs of one
+// strategy over several histories.
+struct Deviation
+{
+  std::size_t runs{};
+  std::size_t tradesDiffer{};
+  double totalReturn{};
+  double sharpe{};
+  double maxDrawdown{};
+  double cagr{};
+  double realizedPnL{};
+
+  void add(const RunOutcome &f64, const RunOutcome &f32)
+  {
+    auto widen = [](double &max, double a, double b) { max = std::max(max, std::fabs(a - b)); };
+    ++runs;
+    tradesDiffer += f64.trades != f32.trades ? 1 : 0;
+    widen(totalReturn, f64.report.totalReturn, f32.report.totalReturn);
+    widen(sharpe, f64.report.sharpe, f32.report.sharpe);
+    widen(maxDrawdown, f64.report.maxDrawdown, f32.report.maxDrawdown);
+    widen(cagr, f64.report.cagr, f32.report.cagr);
+    widen(realizedPnL, f64.report.realizedPnL, f32.report.realizedPnL);
+  }
+};
+
+RunOutcome runPerBar(const std::vector<Candle> &candles, const json &stratCfg,
+                     DataPrecision precision)
+{
+  SweepRunner sweep(candles, stratCfg, initialCash, precision);
+  SweepResult r = sweep.run(1).front();
+  return { r.report, r.trades };
+}
+
+RunOutcome runCrossSectional(std::vector<std::vector<Candle>> series, const json &stratCfg)
+{
+  std::vector<std::string> symbols;
+  for(const auto &s : series)
+  {
+    symbols.push_back(s.front().symbol);
+  }
+  BacktestEngine engine(createCrossSectionalStrategy(symbols, stratCfg),
+                        std::make_unique<SimpleExecutionEngine>(),
+                        std::make_unique<UniverseFeed>(
+                          std::make_unique<MergedFeed>(std::move(series))),
+                        initialCash);
+  Report report = engine.run();
+  return { report, engine.ledger().size() };
+}
+
+// The candles a float32 run sees: every field rounded to float.
+std::vector<Candle> narrowed(const std::vector<Candle> &candles)
+{
+  return toCandles(toBarColumns<float>(candles));
+}
+
+template <typename Feed, typename Data>
+double streamSeconds(const Data &data, const json &stratCfg, std::size_t runs)
+{
+  BenchTimer timer;
+  for(std::size_t r = 0; r < runs; ++r)
+  {
+    auto strategy = createStrategy("SYN", stratCfg);
+    BarFields fields = strategy->barFields();
+    fields |= BarField::Close;
+    std::unique_ptr<DataFeed_I> feed;
+    if constexpr(std::is_same_v<Feed, CandleViewFeed>)
+    {
+      feed = std::make_unique<Feed>(data);
+    }
+    else
+    {
+      feed = std::make_unique<Feed>(data, fields);
+    }
+    BacktestEngine engine(std::move(strategy), std::make_unique<SimpleExecutionEngine>(),
+                          std::move(feed), initialCash);
+    engine.run();
+  }
+  return timer.seconds();
+}
+
+} // namespace
+
+// usage: backtest_bench precision [histories] [bars] [stream bars] [stream runs]
+//
+// Accuracy of float32 bar storage: every bundled strategy runs over the
+// same synthetic histories with double and with float-rounded bars, and
+// the largest Report differences are printed. Then the time to stream a
+// long history through SMA-crossover runs from candles, double columns
+// and float columns.
+int runPrecisionBench(int argc, char **argv)
+{
+  const std::size_t histories = argc > 0 ? std::stoul(argv[0]) : 16;
+  const std::size_t bars = argc > 1 ? std::stoul(argv[1]) : 5000;
+  const std::size_t streamBars = argc > 2 ? std::stoul(argv[2]) : 2000000;
+  const std::size_t streamRuns = argc > 3 ? std::stoul(argv[3]) : 4;
+
+  const LogLevel saved = Log::level();
+  Log::setLevel(LogLevel::Off);
+
+  const std::pair<const char *, json> perBar[] = {
+    { "sma_crossover", { { "short_period", 10 }, { "long_period", 50 } } },
+    { "mean_reversion_zscore",
+      { { "lookback", 20 }, { "entry_zscore", -1.5 }, { "exit_zscore", 0.0 } } },
+    { "trend_rsi",
+      { { "period", 14 }, { "overbought", 70.0 }, { "oversold", 30.0 }, { "trend_window", 50 } } },
+    { "breakout", { { "lookback_window", 20 } } },
+  };
+  const json momentum = { { "name", "momentum_rank" },
+                          { "params", { { "lookback", 60 }, { "top_n", 2 } } } };
+
+  std::vector<std::pair<std::string, Deviation>> rows;
+  for(const auto &[name, params] : perBar)
+  {
+    const json cfg = { { "name", name }, { "params", params } };
+    Deviation d;
+    for(std::size_t h = 0; h < histories; ++h)
+    {
+      const std::vector<Candle> candles = makeSyntheticCandles("SYN", bars, h + 1);
+      d.add(runPerBar(candles, cfg, DataPrecision::Float64),
+            runPerBar(candles, cfg, DataPrecision::Float32));
+    }
+    rows.emplace_back(name, d);
+  }
+  {
+    Deviation d;
+    for(std::size_t h = 0; h < histories; ++h)
+    {
+      std::vector<std::vector<Candle>> series;
+      std::vector<std::vector<Candle>> narrowSeries;
+      for(std::size_t s = 0; s < 8; ++s)
+      {
+        series.push_back(makeSyntheticCandles("S" + std::to_string(s), bars, h * 8 + s + 1));
+        narrowSeries.push_back(narrowed(series.back()));
+      }
+      d.add(runCrossSectional(std::move(series), momentum),
+            runCrossSectional(std::move(narrowSeries), momentum));
+    }
+    rows.emplace_back("momentum_rank (8 symbols)", d);
+  }
+
+  std::cout << "histories:         " << histories << " x " << bars << " daily bars\n"
+            << "largest |float64 - float32| per Report metric:\n";
+  for(const auto &[name, d] : rows)
+  {
+    std::cout << "  " << name << ": trades differ in " << d.tradesDiffer << "/" << d.runs
+              << " runs\n"
+              << "    return " << d.totalReturn << ", sharpe " << d.sharpe << ", max dd "
+              << d.maxDrawdown << ", cagr " << d.cagr << ", realized PnL " << d.realizedPnL
+              << "\n";
+  }
+
+  const json sma = { { "name", "sma_crossover" },
+                     { "params", { { "short_period", 10 }, { "long_period", 50 } } } };
+  const std::vector<Candle> history = makeSyntheticCandles("SYN", streamBars);
+  const BasicBarColumns<double> columns64 = toBarColumns<double>(history);
+  const BasicBarColumns<float> columns32 = toBarColumns<float>(history);
+  const double candleSeconds = streamSeconds<CandleViewFeed>(history, sma, streamRuns);
+  const double double64Seconds =
+    streamSeconds<BarColumnsFeed<double>>(columns64, sma, streamRuns);
+  const double float32Seconds =
+    streamSeconds<BarColumnsFeed<float>>(columns32, sma, streamRuns);
+  Log::setLevel(saved);
+
+  const double total = static_cast<double>(streamBars * streamRuns) / 1e6;
+  std::cout << "streaming:         " << streamRuns << " runs x " << streamBars << " bars\n"
+            << "  candles:         " << total / candleSeconds << " M bars/s ("
+            << sizeof(Candle) << " bytes/bar)\n"
+            << "  float64 columns: " << total / double64Seconds << " M bars/s (16 of 48 "
+            << "bytes/bar read)\n"
+            << "  float32 columns: " << total / float32Seconds << " M bars/s (12 of 28 "
+            << "bytes/bar read)\n";
+  return 0;
+}
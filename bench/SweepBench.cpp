@@ -0,0 +1,78 @@
+#include "BenchUtil.hpp"
+#include "Log.hpp"
+#include "SweepRunner.hpp"
+
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+namespace
+{
+
+// Runs the sweep with logging off; the bundled strategies announce every
+// onStart/onEnd, which would swamp the timing.
+std::vector<SweepResult> runQuiet(const SweepRunner &sweep, std::size_t threads, bool useArenas)
+{
+  const LogLevel saved = Log::level();
+  Log::setLevel(LogLevel::Off);
+  std::vector<SweepResult> results = sweep.run(threads, useArenas);
+  Log::setLevel(saved);
+  return results;
+}
+
+} // namespace
+
+// Many small SMA-crossover backtests over one short history: heap
+// allocation per run vs per-worker arenas reset between runs.
+int runSweepBench(int argc, char **argv)
+{
+  const std::size_t runs = argc > 0 ? std::stoul(argv[0]) : 20000;
+  const std::size_t bars = argc > 1 ? std::stoul(argv[1]) : 250;
+  const std::size_t threads = argc > 2 ? std::stoul(argv[2]) : 0;
+
+  nlohmann::json shortPeriods = nlohmann::json::array();
+  nlohmann::json longPeriods = nlohmann::json::array();
+  const std::size_t shorts = 10;
+  for(std::size_t i = 0; i < shorts; ++i)
+  {
+    shortPeriods.push_back(2 + i);
+  }
+  for(std::size_t i = 0; i < (runs + shorts - 1) / shorts; ++i)
+  {
+    longPeriods.push_back(shorts + 2 + i % 200);
+  }
+
+  nlohmann::json stratCfg = {
+    { "name", "sma_crossover" },
+    { "params", { { "short_period", shortPeriods }, { "long_period", longPeriods } } }
+  };
+
+  SweepRunner sweep(makeSyntheticCandles("SYN", bars), stratCfg, 100000.0);
+
+  BenchTimer heapTimer;
+  std::vector<SweepResult> heap = runQuiet(sweep, threads, false);
+  const double heapSeconds = heapTimer.seconds();
+
+  BenchTimer arenaTimer;
+  std::vector<SweepResult> arena = runQuiet(sweep, threads, true);
+  const double arenaSeconds = arenaTimer.seconds();
+
+  bool identical = heap.size() == arena.size();
+  for(std::size_t i = 0; identical && i < heap.size(); ++i)
+  {
+    identical = std::memcmp(&heap[i].report, &arena[i].report, sizeof(Report)) == 0
+                && heap[i].trades == arena[i].trades;
+  }
+
+  std::cout << "runs:              " << sweep.size() << "\n"
+            << "bars per run:      " << bars << "\n"
+            << "hardware threads:  " << std::thread::hardware_concurrency() << "\n"
+            << "heap:              " << heapSeconds << " s ("
+            << static_cast<double>(sweep.size()) / heapSeconds << " runs/s)\n"
+            << "arena:             " << arenaSeconds << " s ("
+            << static_cast<double>(sweep.size()) / arenaSeconds << " runs/s)\n"
+            << "speedup:           " << heapSeconds / arenaSeconds << "x\n"
+            << "identical reports: " << (identical ? "yes" : "NO") << "\n";
+
+  return identical ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+#include "EnginePhase.hpp"
+
+// ============================================================
+// Heap allocation tracking (build option BACKTEST_ALLOC_TRACKING)
+// ============================================================
+//
+// With the option on, global operator new/delete are replaced by hooks
+// that count every heap allocation of the calling thread, attributed to
+// the engine phase the thread is in. With it off, everything below is an
+// inline no-op and the default allocator is untouched.
+//
+// Strict mode turns allocations inside a trapped region (BacktestEngine
+// arms one around the bar loop once the strategy's warmup is over) into
+// an abort with a backtrace. Amortized storage of results (equity
+// snapshots, ledger chunks, first sight of a symbol) is still counted
+// but explicitly allowed.
+
+#ifndef BACKTEST_ALLOC_TRACKING
+#define BACKTEST_ALLOC_TRACKING 0
+#endif
+
+struct AllocStats
+{
+  std::uint64_t count[enginePhaseCount]{};
+  std::uint64_t bytes[enginePhaseCount]{};
+
+  std::uint64_t totalCount() const;
+  std::uint64_t totalBytes() const;
+
+  AllocStats &operator+=(const AllocStats &other);
+  AllocStats &operator-=(const AllocStats &other);
+};
+
+// Per-phase table; phases without allocations are omitted.
+void writeAllocReport(std::ostream &out, const AllocStats &stats);
+
+class AllocTracker
+{
+public:
+  static constexpr bool enabled = BACKTEST_ALLOC_TRACKING != 0;
+
+  // Counters of the calling thread since it started.
+  static AllocStats threadStats();
+  // Threads that have exited, plus the calling thread.
+  static AllocStats processStats();
+
+  // Process-wide switch for trapping (see AllocTrapScope).
+  static void setStrict(bool on);
+  static bool strict();
+};
+
+#if BACKTEST_ALLOC_TRACKING
+
+// Attributes the calling thread's allocations to `phase`; enter() moves
+// on to the next phase, and the thread's previous phase is restored on
+// destruction.
+class AllocPhaseScope
+{
+public:
+  explicit AllocPhaseScope(EnginePhase phase);
+  ~AllocPhaseScope();
+
+  void enter(EnginePhase phase);
+
+  AllocPhaseScope(const AllocPhaseScope &) = delete;
+  AllocPhaseScope &operator=(const AllocPhaseScope &) = delete;
+
+private:
+  EnginePhase previous_;
+};
+
+// In strict mode, any allocation on the calling thread while this is
+// alive (and no AllocAllowScope is) aborts the process.
+class AllocTrapScope
+{
+public:
+  AllocTrapScope();
+  ~AllocTrapScope();
+
+  AllocTrapScope(const AllocTrapScope &) = delete;
+  AllocTrapScope &operator=(const AllocTrapScope &) = delete;
+};
+
+// Sanctioned allocations inside a trapped region: counted, not trapped.
+class AllocAllowScope
+{
+public:
+  AllocAllowScope();
+  ~AllocAllowScope();
+
+  AllocAllowScope(const AllocAllowScope &) = delete;
+  AllocAllowScope &operator=(const AllocAllowScope &) = delete;
+};
+
+#else
+
+class AllocPhaseScope
+{
+public:
+  explicit AllocPhaseScope(EnginePhase) {}
+  void enter(EnginePhase) {}
+};
+
+class AllocTrapScope
+{
+public:
+  AllocTrapScope() {}
+};
+
+class AllocAllowScope
+{
+public:
+  AllocAllowScope() {}
+};
+
+#endif
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+
+#include "Metrics.hpp"
+#include "SpscRing.hpp"
+#include "TradingTypes.hpp"
+
+// Recording stage of the pipelined engine: snapshots are handed to a
+// dedicated thread over a lock-free ring and appended to Metrics there,
+// keeping history growth off the simulation thread.
+class AsyncRecorder
+{
+public:
+  explicit AsyncRecorder(Metrics &metrics);
+  ~AsyncRecorder();
+
+  AsyncRecorder(const AsyncRecorder &) = delete;
+  AsyncRecorder &operator=(const AsyncRecorder &) = delete;
+
+  void record(const Snapshot &s);
+
+  // Drain everything recorded so far and stop the thread. Metrics may
+  // only be read after this returns.
+  void finish();
+
+private:
+  void consume();
+
+  Metrics &metrics_;
+  SpscRing<Snapshot, 1024> queue_;
+  std::atomic<bool> done_{ false };
+  std::thread worker_;
+};
@@ -1,36 +1,154 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <istream>
 #include <memory>
+#include <memory_resource>
+#include <ostream>
+#include <string>
 #include <vector>
 
 #include "Portfolio.hpp"
 #include "Metrics.hpp"
 #include "Strategy_I.hpp"
+#include "CrossSectionalStrategy_I.hpp"
 #include "DataFeed_I.hpp"
 #include "ExecutionEngine_I.hpp"
 #include "TradingTypes.hpp"
+#include "Rebalancer.hpp"
+#include "AllocTracker.hpp"
+#include "PerfCounters.hpp"
+#include "TradeLedger.hpp"
+#include "feed/UniverseFeed.hpp"
 
+// All per-run containers (orders, portfolio, metrics, ledger) allocate
+// from `resource`; sweeps pass a RunArena so a run is torn down by
+// resetting the arena. The resource must outlive the engine and, in
+// pipelined mode, be thread-safe (the recorder thread appends metrics):
+// setPipelined(true) accepts only the default resource, the heap or a
+// std::pmr::synchronized_pool_resource.
 class BacktestEngine
 {
 public:
   BacktestEngine(std::unique_ptr<Strategy_I> strategy,
                  std::unique_ptr<ExecutionEngine_I> exec,
                  std::unique_ptr<DataFeed_I> feed,
-                 double initialCash);
+                 double initialCash,
+                 std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+  // Cross-sectional mode: the strategy gets one onSlice call per timestamp
+  // with SoA columns over the whole universe instead of one onBar per bar.
+  BacktestEngine(std::unique_ptr<CrossSectionalStrategy_I> strategy,
+                 std::unique_ptr<ExecutionEngine_I> exec,
+                 std::unique_ptr<UniverseFeed> universe,
+                 double initialCash,
+                 std::pmr::memory_resource *resource = std::pmr::get_default_resource());
 
   void placeOrder(const Order &o);
 
+  // Cross-sectional mode only: queue the trades that move the current
+  // holdings onto `targetWeights` (fraction of equity per universe symbol
+  // id). They execute with the slice's other orders in a single batch.
+  void rebalance(const double *targetWeights, std::size_t n);
+  void rebalance(const std::vector<double> &targetWeights)
+  {
+    rebalance(targetWeights.data(), targetWeights.size());
+  }
+  void setRebalanceSettings(const RebalanceSettings &settings);
+
   Report run();
 
+  // Pipelined mode for CPU-heavy strategies: bar decode runs ahead on its
+  // own thread and equity snapshots are recorded on another, connected to
+  // the simulation thread by lock-free queues. Strategy, execution and
+  // portfolio updates stay on one thread because the strategy must see
+  // the portfolio after the previous bar's fills, so results are identical
+  // to the serial loop. Per-bar mode only: a cross-sectional engine, or one
+  // on a resource that is not thread-safe (see above), throws
+  // std::runtime_error. A feed that already is a PrefetchingFeed is not
+  // wrapped again.
+  void setPipelined(bool enabled, std::size_t decodeBlockBars = 4096);
+
+  // Segment support. During the first `bars` bars the strategy sees data
+  // but its orders are dropped and no equity is recorded.
+  void setWarmup(std::size_t bars);
+  // Close any open position in the bar's symbol at the close of each of
+  // these bar indices (after that bar's own orders have executed).
+  void setFlattenPoints(std::vector<std::size_t> barIndices);
+
+  // Checkpointing: save the full engine state after run(), or load it
+  // before run() so the feed is fast-forwarded past every bar the saved
+  // run already processed and only new bars are simulated.
+  // The identity (a hash of the strategy config, symbols and engine
+  // settings, say) is written into the checkpoint, and loading refuses a
+  // checkpoint whose identity differs from the engine's.
+  void setCheckpointIdentity(std::uint64_t identity) { checkpointIdentity_ = identity; }
+  void saveCheckpoint(std::ostream &out) const;
+  void loadCheckpoint(std::istream &in);
+
+  std::size_t barsProcessed() const { return barsProcessed_; }
+
   Portfolio &portfolio() { return portfolio_; }
   const Portfolio &portfolio() const { return portfolio_; }
 
+  const Metrics &metrics() const { return metrics_; }
+
+  // Heap allocations made on the engine's thread during the last run(),
+  // per phase. All zero unless built with BACKTEST_ALLOC_TRACKING.
+  const AllocStats &allocStats() const { return allocStats_; }
+
+  // Hardware counters on the engine's thread for the following runs,
+  // around the whole run or per phase. perfReport() describes the last
+  // run; when the counters cannot be opened it says why and run() goes
+  // ahead without them.
+  void setPerfCounters(PerfMode mode) { perfMode_ = mode; }
+  const PerfReport &perfReport() const { return perfReport_; }
+
+  // Every fill of the run. The ledger is not part of checkpoints; a
+  // resumed run only records the fills it makes itself.
+  const TradeLedger &ledger() const { return ledger_; }
+  void configureLedger(std::size_t memoryLimitBytes, std::string spillPath);
+
+  // Universe of the cross-sectional mode, nullptr in per-bar mode.
+  const UniverseFeed *universe() const { return universe_.get(); }
+
 private:
-  std::vector<Order> pendingOrders_;
+  Report runCrossSectional();
+  void flatten(const Candle &bar);
+  void recordFill(const Fill &fill);
+  void resumeFeed();
+
+  std::pmr::memory_resource *resource_;
+  std::pmr::vector<Order> pendingOrders_;
 
   std::unique_ptr<Strategy_I> strategy_;
   std::unique_ptr<ExecutionEngine_I> exec_;
   std::unique_ptr<DataFeed_I> feed_;
+  std::unique_ptr<CrossSectionalStrategy_I> xsStrategy_;
+  std::unique_ptr<UniverseFeed> universe_;
   Portfolio portfolio_;
   Metrics metrics_;
+  TradeLedger ledger_;
+
+  Rebalancer rebalancer_;
+  std::pmr::vector<const Candle *> batchBars_;
+  std::pmr::vector<Fill> batchFills_;
+
+  std::uint64_t checkpointIdentity_{};
+  std::size_t barsProcessed_{};
+  std::string lastTimestamp_;
+  std::string strategyState_;
+  bool resumed_{};
+
+  std::size_t warmupBars_{};
+  std::vector<std::size_t> flattenPoints_;
+  std::size_t nextFlatten_{};
+
+  AllocStats allocStats_;
+  PerfMode perfMode_{ PerfMode::Off };
+  PerfReport perfReport_;
+
+  bool pipelined_{};
+  std::size_t decodeBlockBars_{ 4096 };
 };
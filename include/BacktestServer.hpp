@@ -0,0 +1,109 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "TradingTypes.hpp"
+
+// ============================================================
+// Backtest server (daemon mode)
+// ============================================================
+//
+// Listens on a Unix domain socket for backtest jobs and keeps every
+// dataset it has loaded resident, so a job pays only for the simulation.
+//
+// Protocol: newline-delimited JSON both ways. A request is a run config
+// as accepted by backtest_engine in "per_bar" or "cross_sectional" mode,
+// built into the same run (see RunBuilder.hpp), plus an optional "id"
+// echoed in the response. Settings the server cannot honour (checkpoints,
+// result cache, trade ledger, trace, log level, perf counters, allocation
+// tracking, float32 data) are rejected. Jobs run on a fixed pool of
+// workers, and each result is written back as soon as it is ready, so a
+// connection with several jobs in flight gets them in completion order:
+//
+//   {"id": 7, "status": "ok", "report": {...}, "final_equity": ...,
+//    "trades": ..., "bars": ..., "elapsed_us": ...}
+//   {"id": 8, "status": "error", "error": "..."}
+class BacktestServer
+{
+public:
+  // Every bar of each symbol as selected by a job's data block (provider,
+  // path, range, lookback_bars), one series per symbol.
+  using Loader = std::function<std::vector<std::vector<Candle>>(
+    const nlohmann::json &dataCfg, const std::vector<std::string> &symbols)>;
+
+  // threads == 0 uses every hardware thread. Without a loader, datasets
+  // come from the data block's provider (see fetchSeries).
+  explicit BacktestServer(std::string socketPath, std::size_t threads = 0, Loader loader = {});
+  ~BacktestServer();
+
+  BacktestServer(const BacktestServer &) = delete;
+  BacktestServer &operator=(const BacktestServer &) = delete;
+
+  // Makes a dataset resident up front, under the key jobs with this data
+  // block and symbol will use.
+  void addDataset(const nlohmann::json &dataCfg, const std::string &symbol,
+                  std::vector<Candle> candles);
+
+  // Binds the socket and serves until stop(); connections still open are
+  // shut down and their queued jobs finished first.
+  void serve();
+
+  // Async-signal-safe: may be called from a signal handler.
+  void stop();
+
+  // Runs one job on the calling thread and returns the response object.
+  // Never throws: failures become {"status": "error"} responses.
+  nlohmann::json runJob(const nlohmann::json &job);
+
+private:
+  struct Connection;
+  struct Job
+  {
+    std::shared_ptr<Connection> connection;
+    std::string request;
+  };
+
+  using Dataset = std::shared_ptr<const std::vector<Candle>>;
+
+  // Resident series of every symbol, loading the missing ones.
+  std::vector<Dataset> datasets(const nlohmann::json &dataCfg,
+                                const std::vector<std::string> &symbols);
+  nlohmann::json execute(const nlohmann::json &job, std::pmr::memory_resource *resource);
+  void readConnection(std::shared_ptr<Connection> connection);
+  void work();
+
+  std::string socketPath_;
+  std::size_t threadCount_;
+  Loader loader_;
+  int wakeFds_[2]{ -1, -1 };
+
+  // Keyed by the bar-selecting part of the data block and the symbol.
+  std::mutex datasetsMutex_;
+  std::map<std::string, Dataset> datasets_;
+
+  std::mutex queueMutex_;
+  std::condition_variable queueReady_;
+  std::deque<Job> queue_;
+  bool stopping_{};
+
+  // One detached reader thread per connection, counted so serve() can
+  // wait for them.
+  std::mutex connectionsMutex_;
+  std::condition_variable readersDone_;
+  std::vector<std::weak_ptr<Connection>> connections_;
+  std::size_t activeReaders_{};
+
+  std::vector<std::thread> workers_;
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Timestamp.hpp"
+#include "TradingTypes.hpp"
+
+// ============================================================
+// Bar columns
+// ============================================================
+//
+// One symbol's bars as columns, sorted by time. Scalar is the stored type
+// of the price and volume columns: double, or float to cut a bar from 48
+// to 28 bytes (time stays int64) when a run streams more history than
+// fits in cache. Feeds widen each value back to double when they fill a
+// Candle, so strategy math, cash and equity are always double; float
+// storage only rounds the inputs, to about 7 significant digits.
+
+enum class DataPrecision : std::uint8_t
+{
+  Float64,
+  Float32
+};
+
+// "float64" or "float32"; throws std::runtime_error otherwise.
+inline DataPrecision parseDataPrecision(const std::string &name)
+{
+  if(name == "float64")
+  {
+    return DataPrecision::Float64;
+  }
+  if(name == "float32")
+  {
+    return DataPrecision::Float32;
+  }
+  throw std::runtime_error("Unsupported data precision: " + name);
+}
+
+// Columns left out of a projected read are empty.
+template <typename Scalar>
+struct BasicBarColumns
+{
+  std::string symbol;
+  std::vector<std::int64_t> time;
+  std::vector<Scalar> open;
+  std::vector<Scalar> high;
+  std::vector<Scalar> low;
+  std::vector<Scalar> close;
+  std::vector<Scalar> volume;
+
+  std::size_t size() const { return time.size(); }
+};
+
+using BarColumns = BasicBarColumns<double>;
+
+// Columns of one symbol's sorted candles, narrowed to Scalar.
+template <typename Scalar>
+BasicBarColumns<Scalar> toBarColumns(const std::vector<Candle> &candles)
+{
+  BasicBarColumns<Scalar> out;
+  if(!candles.empty())
+  {
+    out.symbol = candles.front().symbol;
+  }
+  out.time.reserve(candles.size());
+  for(auto *column : { &out.open, &out.high, &out.low, &out.close, &out.volume })
+  {
+    column->reserve(candles.size());
+  }
+  for(const auto &c : candles)
+  {
+    out.time.push_back(parseTimestamp(c.timestamp));
+    out.open.push_back(static_cast<Scalar>(c.open));
+    out.high.push_back(static_cast<Scalar>(c.high));
+    out.low.push_back(static_cast<Scalar>(c.low));
+    out.close.push_back(static_cast<Scalar>(c.close));
+    out.volume.push_back(static_cast<Scalar>(c.volume));
+  }
+  return out;
+}
+
+// Candles of complete (unprojected) columns, widened to double.
+template <typename Scalar>
+std::vector<Candle> toCandles(const BasicBarColumns<Scalar> &bars)
+{
+  std::vector<Candle> out;
+  out.reserve(bars.size());
+  for(std::size_t i = 0; i < bars.size(); ++i)
+  {
+    out.push_back({ formatTimestamp(bars.time[i]), bars.symbol, bars.open[i], bars.high[i],
+                    bars.low[i], bars.close[i], bars.volume[i] });
+  }
+  return out;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "Timestamp.hpp"
+#include "TradingTypes.hpp"
+
+// ============================================================
+// Local candle store
+// ============================================================
+//
+// One file per symbol (<directory>/<SYMBOL>.bars): a 16-byte header, then
+// fixed-size records (time as seconds since the epoch, open, high, low,
+// close, volume) sorted by time. The newest bar is one seek away and
+// refreshes append to the file in place, so keeping a large universe up
+// to date costs only the new bars.
+
+class CandleStore
+{
+public:
+  explicit CandleStore(std::string directory);
+
+  const std::string &directory() const { return directory_; }
+
+  // Time of the newest stored bar; nullopt when the symbol has none.
+  std::optional<std::int64_t> lastTime(const std::string &symbol) const;
+
+  std::size_t size(const std::string &symbol) const;
+
+  // The last `lookbackBars` bars (<= 0: all) within `range`, oldest first.
+  // Only the records in range are read.
+  std::vector<Candle> load(const std::string &symbol, int lookbackBars = 0,
+                           const TimeRange &range = {}) const;
+
+  // Merges sorted bars into the symbol's history: stored bars within the
+  // new bars' time range are replaced (revised bars included), the rest
+  // kept. A refresh, whose range covers the stored tail, only truncates
+  // the overlap and appends; other merges rewrite the file. Returns the
+  // number of bars the history grew by.
+  std::size_t merge(const std::string &symbol, const std::vector<Candle> &bars);
+
+private:
+  std::string pathFor(const std::string &symbol) const;
+
+  std::string directory_;
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+
+// ============================================================
+// Binary checkpoint streams
+// ============================================================
+//
+// Doubles are written as their raw bit pattern so a resumed run
+// continues from exactly the same values a full rerun would see.
+// The format is host-endian; checkpoints are not meant to move
+// between machines of different architecture.
+
+class CheckpointWriter
+{
+public:
+  explicit CheckpointWriter(std::ostream &out)
+    : out_(out) {}
+
+  void writeU64(std::uint64_t v);
+  void writeI64(std::int64_t v);
+  void writeDouble(double v);
+  void writeString(const std::string &s);
+
+  template <typename Container>
+  void writeDoubles(const Container &values)
+  {
+    writeU64(values.size());
+    for(double v : values)
+    {
+      writeDouble(v);
+    }
+  }
+
+private:
+  std::ostream &out_;
+};
+
+class CheckpointReader
+{
+public:
+  explicit CheckpointReader(std::istream &in)
+    : in_(in) {}
+
+  std::uint64_t readU64();
+  std::int64_t readI64();
+  double readDouble();
+  std::string readString();
+
+  template <typename Container>
+  void readDoubles(Container &values)
+  {
+    values.clear();
+    std::uint64_t count = readU64();
+    for(std::uint64_t i = 0; i < count; ++i)
+    {
+      values.push_back(readDouble());
+    }
+  }
+
+private:
+  std::istream &in_;
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ============================================================
+// Column codec
+// ============================================================
+//
+// Lossless encoding of one column of a columnar chunk, built for fast
+// decode. Values become integers first: timestamps and volumes as they
+// are, prices as fixed-point ticks (value * 10^k for the smallest k that
+// reproduces every value exactly; daily closes quoted in cents get k = 2).
+// The integers are then stored either as zigzag deltas from their
+// predecessor or as offsets from the column minimum, whichever is
+// narrower, bit-packed at one width for the whole block:
+//
+//   header (16 bytes: mode, bit width, decimal scale, base)  packed bits
+//
+// Columns that do not fit (non-decimal prices, NaN, ranges needing more
+// than 56 bits) fall back to raw 8-byte values, so encoding never fails.
+
+enum class ColumnEncoding : std::uint8_t
+{
+  Raw,   // 8-byte values as stored in memory
+  Packed // fixed-point, delta or frame-of-reference, bit-packed
+};
+
+// Appends the encoded column to `out`; returns the block's size in bytes.
+std::size_t encodeColumn(const std::int64_t *values, std::size_t count,
+                         ColumnEncoding encoding, std::vector<std::uint8_t> &out);
+std::size_t encodeColumn(const double *values, std::size_t count,
+                         ColumnEncoding encoding, std::vector<std::uint8_t> &out);
+
+// Decodes a block of `count` values. Throws std::runtime_error when the
+// block is malformed or of the other value type.
+void decodeColumn(const std::uint8_t *block, std::size_t bytes, std::size_t count,
+                  std::int64_t *out);
+void decodeColumn(const std::uint8_t *block, std::size_t bytes, std::size_t count, double *out);
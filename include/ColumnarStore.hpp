@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "BarColumns.hpp"
+#include "ColumnCodec.hpp"
+#include "Timestamp.hpp"
+#include "TradingTypes.hpp"
+
+// ============================================================
+// Columnar dataset files
+// ============================================================
+//
+// A dataset is a directory of shard files plus manifest.json, which maps
+// every symbol to its shard, bar count and time range. A shard holds the
+// bars of many symbols, each split into fixed-size chunks. A chunk is six
+// column blocks (time as seconds since the epoch, open, high, low, close,
+// volume), each encoded on its own by ColumnCodec; the footer indexes
+// every chunk by offset, row count, first/last timestamp and block sizes:
+//
+//   "BTCOLS3\0"  chunks...  footer  footer offset (u64)  "BTCOLS3\0"
+//
+// Writers append symbols one after another and write the footer last, so
+// a shard is built in one pass. A reader binary-searches the chunk index
+// for the start of a time range and reads only the chunks overlapping it.
+
+// Footer index record of one chunk.
+struct ColumnarChunk
+{
+  std::uint64_t offset;         // of the time column's block
+  std::uint64_t rows;
+  std::int64_t first;           // first and last timestamp
+  std::int64_t last;
+  std::uint64_t columnBytes[6]; // encoded block sizes, in column order
+};
+
+class ColumnarShardWriter
+{
+public:
+  // 1024 rows: four years of daily bars, or a trading week of 5-minute
+  // bars, in 48 KiB.
+  static constexpr std::size_t defaultChunkRows = 1024;
+
+  // Packed encoding is lossless and typically shrinks daily bars 3-4x;
+  // columns it cannot represent are stored raw.
+  explicit ColumnarShardWriter(std::string path,
+                               std::size_t chunkRows = defaultChunkRows,
+                               ColumnEncoding encoding = ColumnEncoding::Packed);
+
+  void write(const BarColumns &bars);
+
+  // Writes the footer; the shard is unreadable until then.
+  void finish();
+
+  const std::string &path() const { return path_; }
+  std::uint64_t bytesWritten() const { return offset_; }
+
+private:
+  struct Entry
+  {
+    std::string symbol;
+    std::uint64_t rows;
+    std::vector<ColumnarChunk> chunks;
+  };
+
+  void append(const void *data, std::size_t bytes);
+
+  std::string path_;
+  std::size_t chunkRows_;
+  ColumnEncoding encoding_;
+  std::ofstream out_;
+  std::vector<std::uint8_t> block_; // encode buffer, reused across chunks
+  std::uint64_t offset_{};
+  std::vector<Entry> entries_;
+};
+
+class ColumnarShardReader
+{
+public:
+  explicit ColumnarShardReader(std::string path);
+
+  std::vector<std::string> symbols() const;
+  bool contains(const std::string &symbol) const { return entries_.count(symbol) != 0; }
+
+  // The symbol's bars within `range`: only chunks overlapping it are read,
+  // and of those only the time column and the columns in `fields`.
+  // Throws std::runtime_error when the symbol is not in the shard.
+  BarColumns read(const std::string &symbol, const TimeRange &range = {},
+                  BarFields fields = BarField::All) const;
+
+private:
+  struct Entry
+  {
+    std::uint64_t rows;
+    std::vector<ColumnarChunk> chunks;
+  };
+
+  std::string path_;
+  std::unordered_map<std::string, Entry> entries_;
+};
+
+struct ColumnarManifestEntry
+{
+  std::string symbol;
+  std::string shard; // file name within the dataset directory
+  std::uint64_t rows{};
+  std::int64_t first{};
+  std::int64_t last{};
+};
+
+void writeColumnarManifest(const std::string &directory,
+                           const std::vector<ColumnarManifestEntry> &entries);
+
+// A dataset directory opened through its manifest. Each shard's footer is
+// read once, on first use.
+class ColumnarDataset
+{
+public:
+  explicit ColumnarDataset(std::string directory);
+
+  const std::vector<ColumnarManifestEntry> &entries() const { return entries_; }
+
+  // Throws std::runtime_error when the symbol is not in the dataset.
+  const ColumnarManifestEntry &entry(const std::string &symbol) const;
+
+  BarColumns columns(const std::string &symbol, const TimeRange &range = {},
+                     BarFields fields = BarField::All) const;
+
+  // The last `lookbackBars` bars (<= 0: all) within `range`, as candles;
+  // fields not in `fields` are 0.
+  std::vector<Candle> load(const std::string &symbol, int lookbackBars = 0,
+                           const TimeRange &range = {},
+                           BarFields fields = BarField::All) const;
+
+private:
+  const ColumnarShardReader &shard(const std::string &file) const;
+
+  std::string directory_;
+  std::vector<ColumnarManifestEntry> entries_;
+  std::unordered_map<std::string, std::size_t> index_;
+
+  mutable std::mutex shardsMutex_;
+  mutable std::unordered_map<std::string, std::unique_ptr<ColumnarShardReader>> shards_;
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "TradingTypes.hpp"
+
+class BacktestEngine;
+
+// Structure-of-arrays view over the whole universe at one timestamp.
+// Arrays are indexed by symbol id (the order of the engine's universe)
+// and stay valid until the next slice. Symbols without a bar at this
+// timestamp have valid[i] == 0 and carry their last known close/volume.
+struct UniverseView
+{
+  std::size_t size{};
+  const std::string *timestamp{};
+  const double *close{};
+  const double *volume{};
+  const std::uint8_t *valid{};
+};
+
+// Strategy that sees the universe one timestamp at a time instead of one
+// bar at a time; used by BacktestEngine's cross-sectional mode.
+class CrossSectionalStrategy_I
+{
+public:
+  virtual ~CrossSectionalStrategy_I() = default;
+
+  virtual void onStart(BacktestEngine &engine) = 0;
+  virtual void onSlice(std::size_t index,
+                       const UniverseView &view,
+                       BacktestEngine &engine)
+    = 0;
+  virtual void onEnd(BacktestEngine &engine) = 0;
+
+  // UniverseView columns onSlice reads (BarField::Close / Volume).
+  virtual BarFields barFields() const { return BarField::Close | BarField::Volume; }
+};
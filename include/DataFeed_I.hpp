@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include "TradingTypes.hpp"
 
 class DataFeed_I
@@ -9,4 +10,18 @@ public:
 
   virtual bool hasNext() const = 0;
   virtual const Candle &next() = 0;
+
+  // True when the bar last returned by next() is the final bar of its
+  // timestamp. Single-symbol feeds end a slice on every bar.
+  virtual bool endOfSlice() const { return true; }
+
+  // Advance past `count` bars without handing them to anyone.
+  // Feeds with random access should override this.
+  virtual void skip(std::size_t count)
+  {
+    for(std::size_t i = 0; i < count && hasNext(); ++i)
+    {
+      next();
+    }
+  }
 };
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Phases of one BacktestEngine run. Allocation tracking and hardware
+// performance counters both attribute their measurements to these.
+enum class EnginePhase : std::uint8_t
+{
+  Outside,      // not inside BacktestEngine::run
+  Setup,        // onStart, checkpoint resume, pipeline start
+  Feed,         // fetching the next bar or slice
+  Strategy,     // onBar / onSlice
+  Execution,    // order execution and portfolio fills
+  Ledger,       // trade ledger appends
+  MarkToMarket, // portfolio revaluation
+  Metrics,      // equity snapshots
+  Teardown,     // onEnd and report computation
+  Count
+};
+
+constexpr std::size_t enginePhaseCount = static_cast<std::size_t>(EnginePhase::Count);
+
+const char *enginePhaseName(EnginePhase phase);
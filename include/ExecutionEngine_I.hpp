@@ -1,6 +1,8 @@
 #pragma once
 
+#include <memory_resource>
 #include <optional>
+#include <vector>
 #include "TradingTypes.hpp"
 
 class ExecutionEngine_I
@@ -10,4 +12,24 @@ public:
 
   virtual std::optional<Fill>
   execute(const Order &order, const Candle &bar) = 0;
+
+  // Executes orders[i] against *bars[i] and appends the resulting fills.
+  // Entries with a null bar are skipped. Engines that can price a whole
+  // rebalance at once should override this.
+  virtual void executeBatch(const std::pmr::vector<Order> &orders,
+                            const std::pmr::vector<const Candle *> &bars,
+                            std::pmr::vector<Fill> &fills)
+  {
+    for(std::size_t i = 0; i < orders.size(); ++i)
+    {
+      if(bars[i] == nullptr)
+      {
+        continue;
+      }
+      if(auto fill = execute(orders[i], *bars[i]))
+      {
+        fills.push_back(std::move(*fill));
+      }
+    }
+  }
 };
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <string>
+
+// Name for a temporary file next to `path`, unique to the calling process
+// and thread. Files are written under it and then renamed over `path`, so
+// readers never see a partial file and concurrent writers of the same
+// path never write into each other's temporary.
+std::string uniqueTempPath(const std::string &path);
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// ============================================================
+// Fast non-cryptographic 64-bit hashing
+// ============================================================
+//
+// Word-at-a-time multiply/rotate mixing with a murmur-style
+// finalizer. Good enough to content-address datasets and configs;
+// not suitable where an adversary controls the input.
+
+class Hasher64
+{
+public:
+  explicit Hasher64(std::uint64_t seed = 0x9E3779B97F4A7C15ull)
+    : h_(seed) {}
+
+  void addU64(std::uint64_t v)
+  {
+    h_ ^= v * 0x87C37B91114253D5ull;
+    h_ = (h_ << 31) | (h_ >> 33);
+    h_ *= 0x4CF5AD432745937Full;
+    ++count_;
+  }
+
+  void addDouble(double v)
+  {
+    std::uint64_t bits = 0;
+    std::memcpy(&bits, &v, sizeof(bits));
+    addU64(bits);
+  }
+
+  void addBytes(const void *data, std::size_t size)
+  {
+    const auto *p = static_cast<const unsigned char *>(data);
+    std::size_t i = 0;
+    for(; i + 8 <= size; i += 8)
+    {
+      std::uint64_t word = 0;
+      std::memcpy(&word, p + i, 8);
+      addU64(word);
+    }
+
+    std::uint64_t tail = 0;
+    std::memcpy(&tail, p + i, size - i);
+    addU64(tail ^ (static_cast<std::uint64_t>(size) << 56));
+  }
+
+  void addString(const std::string &s)
+  {
+    addBytes(s.data(), s.size());
+  }
+
+  std::uint64_t digest() const
+  {
+    std::uint64_t h = h_ ^ count_;
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return h;
+  }
+
+private:
+  std::uint64_t h_;
+  std::uint64_t count_{};
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// ============================================================
+// Concurrent HTTP fetching
+// ============================================================
+//
+// HttpFetcher runs GET requests on one curl multi handle. Transfers share
+// its connection cache (kept alive between fetchAll() calls) and a DNS
+// and TLS session cache, so a universe of symbols costs one handshake per
+// connection rather than per request. Responses may be gzip or deflate
+// compressed; curl decodes them.
+//
+// Requests start no faster than `requestsPerMinute`, spaced evenly, and
+// at most `concurrency` are in flight. Transport errors, 429 and 5xx
+// responses are retried up to `retries` times, through the same
+// schedule. Not thread-safe: use one fetcher per thread.
+
+struct HttpFetchOptions
+{
+  std::size_t concurrency{ 8 };
+  double requestsPerMinute{}; // 0: no limit
+  std::size_t retries{ 2 };
+  std::chrono::milliseconds timeout{ 30000 };
+};
+
+struct HttpResponse
+{
+  long status{}; // 0 when the transfer itself failed
+  std::string body;
+  std::string error; // transport error or "HTTP <status>"
+
+  bool ok() const { return status == 200; }
+};
+
+class HttpFetcher
+{
+public:
+  explicit HttpFetcher(HttpFetchOptions options = {});
+  ~HttpFetcher();
+
+  HttpFetcher(const HttpFetcher &) = delete;
+  HttpFetcher &operator=(const HttpFetcher &) = delete;
+
+  // One response per URL, in the order given. Failures are reported in
+  // the responses, not thrown.
+  std::vector<HttpResponse> fetchAll(const std::vector<std::string> &urls);
+
+  // Single GET; throws std::runtime_error unless the status is 200.
+  std::string get(const std::string &url);
+
+  // Transfers so far that opened a new connection instead of reusing one.
+  std::size_t connectionsOpened() const { return connectionsOpened_; }
+
+private:
+  void *acquireHandle();
+
+  HttpFetchOptions options_;
+  void *multi_;
+  void *share_;
+  std::vector<void *> idle_; // easy handles kept for reuse
+  std::chrono::steady_clock::time_point nextStart_{};
+  std::size_t connectionsOpened_{};
+};
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// ============================================================
+// Asynchronous logging
+// ============================================================
+//
+//   BACKTEST_LOG(Info, "Fetched {} candles for {}", candles.size(), symbol);
+//
+// Below the current level the macro is one branch and the arguments are
+// not evaluated. Otherwise the format pointer and the arguments are
+// appended in binary form to the calling thread's own buffer; a
+// background thread drains the buffers, formats the records in time
+// order and writes them out. `{}` marks an argument; the format must be a
+// string literal (it is kept by pointer).
+//
+// Info goes to stdout as plain text, the other levels to stderr with a
+// level prefix. A LogContext tag ("sweep run 12") is prepended to every
+// record its thread writes while it is alive; it is kept as a literal and
+// a number, so setting one per run costs nothing when nothing is logged. Call Log::flush() before
+// writing to the console directly, so earlier records come out first.
+
+#define BACKTEST_LOG(level, ...)                                  \
+  do                                                              \
+  {                                                               \
+    if(Log::enabled(LogLevel::level))                             \
+    {                                                             \
+      Log::write(LogLevel::level, __VA_ARGS__);                   \
+    }                                                             \
+  } while(0)
+
+enum class LogLevel : std::uint8_t
+{
+  Debug,
+  Info,
+  Warn,
+  Error,
+  Off
+};
+
+const char *logLevelName(LogLevel level);
+// "debug", "info", "warn", "error" or "off"; throws std::runtime_error.
+LogLevel parseLogLevel(const std::string &name);
+
+class Log
+{
+public:
+  static bool enabled(LogLevel level)
+  {
+    return level >= threshold_.load(std::memory_order_relaxed);
+  }
+
+  static void setLevel(LogLevel level) { threshold_.store(level, std::memory_order_relaxed); }
+  static LogLevel level() { return threshold_.load(std::memory_order_relaxed); }
+
+  // Send every level to `out` instead of stdout/stderr; nullptr restores
+  // the default. `out` must outlive the logging.
+  static void setSink(std::ostream *out);
+
+  // Blocks until everything logged before the call has been written.
+  static void flush();
+
+  template <typename... Args>
+  static void write(LogLevel level, const char *format, const Args &...args);
+
+private:
+  inline static std::atomic<LogLevel> threshold_{ LogLevel::Info };
+};
+
+// Tags the calling thread's records with `name` (a string literal) and,
+// when non-negative, `id` until destroyed; restores the previous tag.
+class LogContext
+{
+public:
+  explicit LogContext(const char *name, std::int64_t id = -1);
+  ~LogContext();
+
+  LogContext(const LogContext &) = delete;
+  LogContext &operator=(const LogContext &) = delete;
+
+private:
+  const char *previousName_;
+  std::int64_t previousId_;
+};
+
+// Appends one record to the calling thread's buffer, holding that
+// buffer's lock (only the drain thread ever competes for it) until
+// destroyed.
+class LogRecordWriter
+{
+public:
+  enum class Type : std::uint8_t
+  {
+    Int,
+    UInt,
+    Double,
+    Bool,
+    String
+  };
+
+  LogRecordWriter(LogLevel level, const char *format, std::size_t argCount);
+  ~LogRecordWriter();
+
+  LogRecordWriter(const LogRecordWriter &) = delete;
+  LogRecordWriter &operator=(const LogRecordWriter &) = delete;
+
+  template <typename T>
+  void put(const T &value)
+  {
+    if constexpr(std::is_same_v<T, bool>)
+    {
+      putScalar(Type::Bool, std::uint64_t{ value });
+    }
+    else if constexpr(std::is_same_v<T, char>)
+    {
+      putString(std::string_view(&value, 1));
+    }
+    else if constexpr(std::is_integral_v<T> && std::is_signed_v<T>)
+    {
+      putScalar(Type::Int, static_cast<std::int64_t>(value));
+    }
+    else if constexpr(std::is_integral_v<T> || std::is_enum_v<T>)
+    {
+      putScalar(Type::UInt, static_cast<std::uint64_t>(value));
+    }
+    else if constexpr(std::is_floating_point_v<T>)
+    {
+      putScalar(Type::Double, static_cast<double>(value));
+    }
+    else
+    {
+      putString(std::string_view(value));
+    }
+  }
+
+private:
+  template <typename Scalar>
+  void putScalar(Type type, Scalar value)
+  {
+    char bytes[sizeof(Scalar)];
+    std::memcpy(bytes, &value, sizeof(Scalar));
+    append(&type, 1);
+    append(bytes, sizeof(Scalar));
+  }
+
+  void putString(std::string_view text);
+  void append(const void *data, std::size_t n);
+
+  void *log_;
+  std::size_t start_;
+};
+
+template <typename... Args>
+void Log::write(LogLevel level, const char *format, const Args &...args)
+{
+  LogRecordWriter record(level, format, sizeof...(Args));
+  (record.put(args), ...);
+}
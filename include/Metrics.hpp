@@ -1,16 +1,37 @@
 #pragma once
 
+#include <memory_resource>
 #include <vector>
 #include <string>
 #include "TradingTypes.hpp"
 #include "Portfolio.hpp"
+#include "AllocTracker.hpp"
+
+class CheckpointWriter;
+class CheckpointReader;
+
+Snapshot makeSnapshot(const Portfolio &p, const std::string &ts);
 
 class Metrics
 {
 public:
+  explicit Metrics(std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+    : snapshots_(resource) {}
+
   void recordStep(const Portfolio &p, const std::string &ts);
+  void record(const Snapshot &s)
+  {
+    // See recordStep.
+    AllocAllowScope allow;
+    snapshots_.push_back(s);
+  }
   Report computeReport() const;
 
+  const std::pmr::vector<Snapshot> &snapshots() const { return snapshots_; }
+
+  void saveState(CheckpointWriter &out) const;
+  void loadState(CheckpointReader &in);
+
 private:
-  std::vector<Snapshot> snapshots_;
+  std::pmr::vector<Snapshot> snapshots_;
 };
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+// ============================================================
+// Money representation
+// ============================================================
+//
+// Fill prices, fees, cost bases, cash and PnL use `Money`. By default it
+// is a double. Building with -DBACKTEST_FIXED_POINT_MONEY=ON makes it an
+// int64 count of micro-units (1e-6 of the currency): every sum and
+// product is then exact, so cash and PnL do not depend on the order fills
+// and positions are accumulated in, and runs reproduce bit for bit at any
+// thread count. The range is about +-9.2e12 currency units.
+//
+// Market data (Candle) and strategy math stay in double; prices cross
+// into Money when the execution engine fills an order (rounded to the
+// symbol's tick size) or the portfolio marks a position.
+
+#if BACKTEST_FIXED_POINT_MONEY
+
+using Money = std::int64_t;
+
+constexpr bool fixedPointMoney = true;
+constexpr double moneyUnitsPerCurrency = 1e6;
+
+inline Money toMoney(double value)
+{
+  return static_cast<Money>(std::llround(value * moneyUnitsPerCurrency));
+}
+
+inline double fromMoney(Money value)
+{
+  return static_cast<double>(value) / moneyUnitsPerCurrency;
+}
+
+// Rounds half away from zero, so the result does not depend on the sign.
+inline Money divideMoney(Money value, std::int64_t divisor)
+{
+  const Money half = divisor / 2;
+  return (value >= 0 ? value + half : value - half) / divisor;
+}
+
+#else
+
+using Money = double;
+
+constexpr bool fixedPointMoney = false;
+
+inline Money toMoney(double value) { return value; }
+inline double fromMoney(Money value) { return value; }
+
+inline Money divideMoney(Money value, std::int64_t divisor)
+{
+  return value / static_cast<double>(divisor);
+}
+
+#endif
+
+// Nearest multiple of `tick` (<= 0: unchanged).
+inline double roundToTick(double price, double tick)
+{
+  return tick > 0.0 ? std::round(price / tick) * tick : price;
+}
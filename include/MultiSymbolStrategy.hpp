@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Strategy_I.hpp"
+
+// Runs one single-symbol strategy per symbol over a merged feed,
+// dispatching each bar only to the strategy that owns its symbol.
+class MultiSymbolStrategy : public Strategy_I
+{
+public:
+  void add(const std::string &symbol, std::unique_ptr<Strategy_I> strategy);
+
+  void onStart(BacktestEngine &engine) override;
+  void onBar(std::size_t index,
+             const Candle &bar,
+             BacktestEngine &engine) override;
+  void onEnd(BacktestEngine &engine) override;
+
+  // Union of the symbol strategies' fields.
+  BarFields barFields() const override;
+
+  void saveState(CheckpointWriter &out) const override;
+  void loadState(CheckpointReader &in) override;
+
+private:
+  std::vector<std::unique_ptr<Strategy_I>> strategies_;
+  std::unordered_map<std::string, std::size_t> bySymbol_;
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "EnginePhase.hpp"
+
+// ============================================================
+// Hardware performance counters (Linux perf_event_open)
+// ============================================================
+//
+// A counter group of the calling thread: cycles, instructions, L1 data
+// cache read misses, last-level cache misses and branch mispredictions,
+// user space only. Events the CPU or kernel does not offer are left out
+// of the group; when none can be opened (no PMU in a container or VM,
+// perf_event_paranoid too strict, another OS) the group is unavailable,
+// reads return zeros and status() says why. Nothing here throws for a
+// missing counter.
+
+enum class PerfEvent : std::uint8_t
+{
+  Cycles,
+  Instructions,
+  L1dMisses,
+  LlcMisses,
+  BranchMisses,
+  Count
+};
+
+constexpr std::size_t perfEventCount = static_cast<std::size_t>(PerfEvent::Count);
+
+const char *perfEventName(PerfEvent event);
+
+struct PerfSample
+{
+  std::uint64_t value[perfEventCount]{};
+
+  std::uint64_t operator[](PerfEvent event) const
+  {
+    return value[static_cast<std::size_t>(event)];
+  }
+
+  PerfSample &operator+=(const PerfSample &other);
+  PerfSample &operator-=(const PerfSample &other);
+};
+
+class PerfCounters
+{
+public:
+  // Opens and starts the group; it counts the thread that constructs it.
+  PerfCounters();
+  ~PerfCounters();
+
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters &operator=(const PerfCounters &) = delete;
+
+  bool available() const { return events_ != 0; }
+  bool has(PerfEvent event) const { return (events_ >> static_cast<unsigned>(event)) & 1u; }
+  unsigned events() const { return events_; }
+
+  // Why the group or some of its events are missing; empty when complete.
+  const std::string &status() const { return status_; }
+
+  // Counts since construction, scaled up if the kernel had to multiplex
+  // the group with other users of the PMU. One syscall.
+  PerfSample read() const;
+
+private:
+  int leader_{ -1 };
+  int fds_[perfEventCount];
+  unsigned events_{}; // bit per PerfEvent in the group
+  std::size_t slot_[perfEventCount]{}; // position in the group read
+  std::string status_;
+};
+
+enum class PerfMode : std::uint8_t
+{
+  Off,
+  Run,   // one reading around the whole run
+  Phases // a reading at every phase change, a syscall each
+};
+
+// Counters of one BacktestEngine run, on the engine's thread.
+struct PerfReport
+{
+  PerfMode mode{ PerfMode::Off };
+  bool available{};
+  unsigned events{}; // bit per PerfEvent that was counted
+  std::string status;
+  std::size_t bars{}; // bars (or slices) simulated by the run
+  PerfSample total;
+  // PerfMode::Phases only. Ledger appends happen inside execution and
+  // are counted there.
+  PerfSample phase[enginePhaseCount];
+};
+
+// Per-run and per-bar table, with a per-phase breakdown in phase mode.
+void writePerfReport(std::ostream &out, const PerfReport &report);
@@ -1,24 +1,64 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
 #include <unordered_map>
 #include <string>
+#include <vector>
 #include "TradingTypes.hpp"
 
+class CheckpointWriter;
+class CheckpointReader;
+
 class Portfolio
 {
 public:
-  explicit Portfolio(double initialCash = 0.0)
-    : cash_(initialCash) {}
+  explicit Portfolio(double initialCash = 0.0,
+                     std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+    : cash_(toMoney(initialCash)),
+      positions_(resource),
+      index_(resource) {}
 
-  void applyFill(const Fill &f);
+  // Returns the PnL realized by this fill (zero when it only adds).
+  double applyFill(const Fill &f);
   void markToMarket(const Candle &bar);
 
+  // Cross-sectional mode: pre-create one position per universe symbol so
+  // positions()[id] lines up with the universe's symbol ids, then revalue
+  // them in a single pass over the universe's SoA columns.
+  void bindUniverse(const std::vector<std::string> &symbols);
+  void markToMarket(const double *close, const std::uint8_t *valid, std::size_t n);
+
+  const std::pmr::vector<Position> &positions() const { return positions_; }
+
+  // Realized PnL is accumulated on every fill, so this is O(1); equity
+  // and unrealized PnL are one pass over the open positions.
   double getEquity() const;
-  double getCash() const { return cash_; }
+  double getCash() const { return fromMoney(cash_); }
+  double getRealizedPnL() const { return fromMoney(realizedPnL_); }
+  double getUnrealizedPnL() const;
 
+  struct Valuation
+  {
+    double equity{};
+    double unrealizedPnL{};
+  };
+  Valuation valuation() const;
+
+  // The returned pointer stays valid until a fill opens a new symbol.
   const Position *getPosition(const std::string &symbol) const;
 
+  void saveState(CheckpointWriter &out) const;
+  void loadState(CheckpointReader &in);
+
 private:
-  double cash_{};
-  std::unordered_map<std::string, Position> positions_;
+  Position &positionFor(const std::string &symbol);
+
+  Money cash_{};
+  Money realizedPnL_{};
+  // Positions are kept in first-fill order so equity is always summed in
+  // the same order, which keeps checkpointed runs bit-identical.
+  std::pmr::vector<Position> positions_;
+  std::pmr::unordered_map<std::string, std::size_t> index_;
 };
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "TradingTypes.hpp"
+
+struct RebalanceSettings
+{
+  int lotSize{ 1 };           // target quantities are rounded toward zero to whole lots
+  double minTradeValue{ 0.0 }; // skip trades whose notional is below this
+};
+
+// Turns a target-weight vector into the trades that move the current
+// holdings onto it. All inputs are SoA arrays indexed by universe symbol
+// id; the diff is one linear pass and reuses the caller's order buffer.
+// `positions` must hold at least n entries.
+class Rebalancer
+{
+public:
+  explicit Rebalancer(RebalanceSettings settings = {})
+    : settings_(settings) {}
+
+  const RebalanceSettings &settings() const { return settings_; }
+
+  // Appends one order per symbol whose holding must change. Symbols that
+  // are not valid this slice (or have no price) keep their holding.
+  void computeTrades(const double *targetWeights,
+                     const double *close,
+                     const std::uint8_t *valid,
+                     const Position *positions,
+                     std::size_t n,
+                     double equity,
+                     std::pmr::vector<Order> &out) const;
+
+private:
+  RebalanceSettings settings_;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "TradingTypes.hpp"
+
+// ============================================================
+// Content-addressed backtest result store
+// ============================================================
+//
+// A result is keyed by the hash of the candle columns, the canonical
+// (key-sorted) run configuration and the running binary itself, so any
+// change to the data, the parameters or the code produces a new key and
+// stale entries are simply never looked up again.
+
+struct CachedResult
+{
+  Report report;
+  double finalEquity{};
+  std::vector<Snapshot> equityCurve;
+};
+
+// The Report fields as a JSON object, as stored in cache entries and sent
+// by the backtest server.
+nlohmann::json reportToJson(const Report &report);
+Report reportFromJson(const nlohmann::json &j);
+
+std::uint64_t hashCandles(const std::vector<Candle> &candles);
+std::uint64_t hashCandles(const std::vector<std::vector<Candle>> &series);
+// Combines per-series hashCandles() values the way the overload above does.
+std::uint64_t combineSeriesHashes(const std::vector<std::uint64_t> &hashes);
+
+// Hash of the running executable; falls back to the build date when the
+// binary cannot be read.
+std::uint64_t codeVersionHash();
+
+class ResultCache
+{
+public:
+  explicit ResultCache(std::string directory);
+
+  static std::string makeKey(std::uint64_t datasetHash,
+                             const nlohmann::json &runConfig);
+
+  std::optional<CachedResult> lookup(const std::string &key) const;
+  void store(const std::string &key, const CachedResult &result) const;
+
+private:
+  std::string pathFor(const std::string &key) const;
+
+  std::string directory_;
+};
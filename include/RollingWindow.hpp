@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <memory_resource>
+#include <vector>
+
+// Fixed-capacity window over the most recent values: push_back drops the
+// oldest value once the window is full. Storage is allocated once, so a
+// strategy's rolling history costs no allocations per bar (a std::deque
+// allocates a node every few dozen bars as it slides).
+//
+// Element 0 is the oldest value and back() the newest, like the deque
+// it replaces; iteration runs oldest to newest.
+template <typename T>
+class RollingWindow
+{
+public:
+  class const_iterator
+  {
+  public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T *;
+    using reference = const T &;
+
+    const_iterator(const RollingWindow *window, std::size_t index)
+      : window_(window), index_(index) {}
+
+    reference operator*() const { return (*window_)[index_]; }
+    const_iterator &operator++()
+    {
+      ++index_;
+      return *this;
+    }
+    const_iterator &operator--()
+    {
+      --index_;
+      return *this;
+    }
+    bool operator==(const const_iterator &other) const { return index_ == other.index_; }
+    bool operator!=(const const_iterator &other) const { return index_ != other.index_; }
+
+  private:
+    const RollingWindow *window_;
+    std::size_t index_;
+  };
+
+  explicit RollingWindow(std::size_t capacity,
+                         std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+    : values_(capacity > 0 ? capacity : 1, T{}, resource) {}
+
+  void push_back(const T &value)
+  {
+    std::size_t slot = head_ + size_;
+    if(slot >= values_.size())
+    {
+      slot -= values_.size();
+    }
+    values_[slot] = value;
+
+    if(size_ < values_.size())
+    {
+      ++size_;
+    }
+    else if(++head_ == values_.size())
+    {
+      head_ = 0;
+    }
+  }
+
+  void clear()
+  {
+    head_ = 0;
+    size_ = 0;
+  }
+
+  std::size_t size() const { return size_; }
+  std::size_t capacity() const { return values_.size(); }
+  bool empty() const { return size_ == 0; }
+  bool full() const { return size_ == values_.size(); }
+
+  const T &operator[](std::size_t i) const
+  {
+    std::size_t slot = head_ + i;
+    return values_[slot < values_.size() ? slot : slot - values_.size()];
+  }
+
+  const T &back() const { return (*this)[size_ - 1]; }
+
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, size_); }
+
+private:
+  std::pmr::vector<T> values_;
+  std::size_t head_{};
+  std::size_t size_{};
+};
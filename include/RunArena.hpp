@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+// Per-run arena for engine state. The containers of one backtest
+// (portfolio, metrics, order buffers, strategy windows, ledger chunks)
+// allocate from resource(), and reset() drops all of it at once instead
+// of freeing every allocation. Memory freed during the run, such as a
+// strategy's sliding window, is recycled by a pool so long runs stay
+// bounded.
+//
+// Not thread-safe: a worker owns one arena and reuses it for all its
+// runs. When a run outgrows the initial buffer, the next reset() enlarges
+// the buffer to that run's footprint (up to maxBufferBytes), so repeated
+// runs of similar size stop reaching the system allocator after the first.
+class RunArena
+{
+public:
+  explicit RunArena(std::size_t initialBytes = 256u << 10,
+                    std::size_t maxBufferBytes = 64u << 20);
+
+  RunArena(const RunArena &) = delete;
+  RunArena &operator=(const RunArena &) = delete;
+
+  std::pmr::memory_resource *resource() { return &*pool_; }
+
+  // Releases everything allocated since the last reset. Every object that
+  // allocated from resource() must be destroyed first.
+  void reset();
+
+  std::size_t bufferBytes() const { return bufferBytes_; }
+
+private:
+  // Upstream of the monotonic buffer: forwards to operator new and counts
+  // the bytes needed beyond the initial buffer.
+  class OverflowResource : public std::pmr::memory_resource
+  {
+  public:
+    std::size_t total{};
+
+  private:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+  };
+
+  void rebuild();
+
+  std::unique_ptr<std::byte[]> buffer_;
+  std::size_t bufferBytes_;
+  std::size_t maxBufferBytes_;
+  OverflowResource overflow_;
+  std::optional<std::pmr::monotonic_buffer_resource> monotonic_;
+  std::optional<std::pmr::unsynchronized_pool_resource> pool_;
+};
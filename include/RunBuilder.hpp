@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "BacktestEngine.hpp"
+#include "SharedDataset.hpp"
+#include "Timestamp.hpp"
+#include "TradingTypes.hpp"
+
+// ============================================================
+// Run builder
+// ============================================================
+//
+// Data loading and engine construction for a run config, shared by
+// backtest_engine and the backtest server so that a config means the same
+// run to both.
+
+// Top-level config: a single "asset" or a list of "assets".
+std::vector<std::string> configSymbols(const nlohmann::json &cfg);
+
+// Optional "start"/"end" dates of the data block; lookback_bars then
+// counts back from the end of the range.
+TimeRange dataRange(const nlohmann::json &dataCfg);
+
+// Candle fields a run reads: the strategy's (asked of a probe instance,
+// the first grid point in sweep mode) plus the close the engine marks
+// positions and fills orders at.
+BarFields runBarFields(const std::string &mode,
+                       const std::vector<std::string> &symbols,
+                       const nlohmann::json &stratCfg);
+
+// One candle series per symbol from the data block's "alpha_vantage" or
+// "columnar" provider. Columnar datasets only read the columns in `fields`.
+std::vector<std::vector<Candle>> fetchSeries(const nlohmann::json &dataCfg,
+                                             const std::vector<std::string> &symbols,
+                                             BarFields fields = BarField::All);
+
+// The bars of a run, one series per symbol in config order: either owned
+// by the run or resident elsewhere (the server's datasets) and shared.
+// A "shared_memory" dataset is read in place by per_bar runs instead.
+struct RunData
+{
+  std::vector<std::vector<Candle>> series;
+  std::vector<std::shared_ptr<const std::vector<Candle>>> resident;
+
+  std::shared_ptr<const SharedDataset> shared;
+  std::vector<std::size_t> sharedIds;
+  int sharedLookback{};
+  TimeRange sharedRange;
+  BarFields fields{ BarField::All };
+};
+
+// Attaches a "shared_memory" dataset (copying its symbols' bars out for
+// modes other than per_bar) or fetches the series of any other provider.
+RunData loadRunData(const nlohmann::json &dataCfg,
+                    const std::vector<std::string> &symbols,
+                    const std::string &mode,
+                    BarFields fields);
+
+// Engine of a "per_bar" or "cross_sectional" run config over `data`, with
+// the engine block's tick sizes, rebalance settings and pipelined mode and
+// the data block's prefetch_bars applied. Owned series are moved out of
+// `data`; a single resident series is read in place, so it must outlive
+// the engine. Throws std::runtime_error for any other mode.
+std::unique_ptr<BacktestEngine>
+buildEngine(const nlohmann::json &cfg,
+            RunData &data,
+            std::pmr::memory_resource *resource = std::pmr::get_default_resource());
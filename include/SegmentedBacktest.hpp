@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "ExecutionEngine_I.hpp"
+#include "Strategy_I.hpp"
+#include "TradingTypes.hpp"
+
+struct SegmentedResult
+{
+  Report report;
+  double finalEquity{};
+  std::vector<Snapshot> equityCurve;
+};
+
+// Runs one long single-symbol backtest as K independent segments.
+//
+// Requirements on the strategy: it declares a bounded warmupBars(), and
+// its orders do not depend on the cash balance. Each segment replays
+// warmupBars() bars before its start with trading disabled, and every
+// segment ends flat (open positions are closed at its last bar's close).
+// Segment PnL is therefore independent of where the segment starts, and
+// the per-segment equity curves are stitched by chaining each segment's
+// PnL onto the previous segment's final equity.
+class SegmentedBacktest
+{
+public:
+  using StrategyMaker = std::function<std::unique_ptr<Strategy_I>()>;
+  using ExecutionMaker = std::function<std::unique_ptr<ExecutionEngine_I>()>;
+
+  SegmentedBacktest(std::vector<Candle> candles,
+                    StrategyMaker makeStrategy,
+                    ExecutionMaker makeExecution,
+                    double initialCash,
+                    std::size_t segments);
+
+  // Segments run concurrently on `threads` workers (0 = hardware threads).
+  SegmentedResult runParallel(std::size_t threads = 0) const;
+
+  // Reference: one serial engine over the whole history that flattens at
+  // the same segment boundaries. runParallel must match it.
+  SegmentedResult runSerial() const;
+
+  static bool equivalent(const SegmentedResult &a,
+                         const SegmentedResult &b,
+                         double relTolerance = 1e-9);
+
+  std::size_t segmentCount() const { return bounds_.size() - 1; }
+
+private:
+  struct SegmentRun
+  {
+    std::vector<Snapshot> curve;
+  };
+
+  SegmentRun runSegment(std::size_t k) const;
+
+  std::vector<Candle> candles_;
+  StrategyMaker makeStrategy_;
+  ExecutionMaker makeExecution_;
+  double initialCash_;
+  std::size_t warmup_;
+  std::vector<std::size_t> bounds_; // segment k covers [bounds_[k], bounds_[k + 1])
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Timestamp.hpp"
+#include "TradingTypes.hpp"
+
+// ============================================================
+// Shared-memory datasets
+// ============================================================
+//
+// publishSharedDataset() writes candle series into one POSIX shared memory
+// object as immutable columns; SharedDataset maps it read-only. Every
+// process attached to the same name shares one physical copy, and
+// attaching only maps the object: pages are faulted in as bars are read.
+//
+// Layout: a header and a manifest of the symbols (name, first row, bar
+// count, content hash), then one 64-byte aligned column per field over
+// all rows, symbol after symbol:
+//
+//   time (int64 seconds since the epoch)  open  high  low  close  volume
+//
+// The object is named "/backtest.<name>" and lives until
+// removeSharedDataset() (or a reboot); attached processes keep their
+// mapping even after it is removed or replaced.
+
+class SharedDataset
+{
+public:
+  // One symbol's bars, sorted by time.
+  struct Series
+  {
+    std::string symbol;
+    const std::int64_t *time;
+    const double *open;
+    const double *high;
+    const double *low;
+    const double *close;
+    const double *volume;
+    std::size_t size;
+    std::uint64_t hash; // hashCandles() of the published candles
+  };
+
+  // Maps the published dataset; throws std::runtime_error when it does not
+  // exist, is still being written or has an unknown layout.
+  explicit SharedDataset(const std::string &name);
+  ~SharedDataset();
+
+  SharedDataset(const SharedDataset &) = delete;
+  SharedDataset &operator=(const SharedDataset &) = delete;
+
+  const std::string &name() const { return name_; }
+  std::size_t bytes() const { return bytes_; }
+
+  std::size_t symbolCount() const { return series_.size(); }
+  const Series &series(std::size_t id) const { return series_[id]; }
+
+  // Id of a symbol; throws std::runtime_error when it was not published.
+  std::size_t idOf(const std::string &symbol) const;
+
+  // Copies the last `lookbackBars` bars (<= 0: all) of a symbol within
+  // `range` out as candles, for modes that need an owned vector. Fields
+  // not in `fields` are 0.
+  std::vector<Candle> candles(std::size_t id, int lookbackBars = 0,
+                              const TimeRange &range = {},
+                              BarFields fields = BarField::All) const;
+
+private:
+  std::string name_;
+  const void *base_{};
+  std::size_t bytes_{};
+  std::vector<Series> series_;
+};
+
+// Publishes one sorted series per symbol under `name`, replacing an
+// earlier dataset of that name. Returns the size of the object in bytes.
+std::size_t publishSharedDataset(const std::string &name,
+                                 const std::vector<std::vector<Candle>> &series);
+
+// Unlinks the dataset; returns false when it did not exist.
+bool removeSharedDataset(const std::string &name);
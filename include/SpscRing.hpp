@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Bounded lock-free single-producer / single-consumer ring.
+// Exactly one thread may push and exactly one thread may pop.
+// Capacity must be a power of two.
+template <typename T, std::size_t Capacity>
+class SpscRing
+{
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                "SpscRing capacity must be a power of two");
+
+public:
+  bool tryPush(const T &v)
+  {
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    if(tail - head_.load(std::memory_order_acquire) == Capacity)
+    {
+      return false;
+    }
+    slots_[tail & (Capacity - 1)] = v;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side: peek at the oldest element without removing it.
+  T *front()
+  {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    if(head == tail_.load(std::memory_order_acquire))
+    {
+      return nullptr;
+    }
+    return &slots_[head & (Capacity - 1)];
+  }
+
+  bool tryPop(T &out)
+  {
+    T *slot = front();
+    if(slot == nullptr)
+    {
+      return false;
+    }
+    out = *slot;
+    head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    return true;
+  }
+
+private:
+  std::array<T, Capacity> slots_{};
+  alignas(64) std::atomic<std::size_t> head_{ 0 };
+  alignas(64) std::atomic<std::size_t> tail_{ 0 };
+};
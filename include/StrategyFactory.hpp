@@ -1,11 +1,27 @@
 #pragma once
 
 #include <memory>
+#include <memory_resource>
 #include <string>
+#include <vector>
 #include <nlohmann/json.hpp>
 
 #include "Strategy_I.hpp"
+#include "CrossSectionalStrategy_I.hpp"
+#include "exec/SimpleExecutionEngine.hpp"
 
+// Strategies allocate their rolling state from `resource`; it must
+// outlive the strategy.
 std::unique_ptr<Strategy_I>
 createStrategy(const std::string &symbol,
-               const nlohmann::json &stratCfg);
+               const nlohmann::json &stratCfg,
+               std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+std::unique_ptr<CrossSectionalStrategy_I>
+createCrossSectionalStrategy(const std::vector<std::string> &symbols,
+                             const nlohmann::json &stratCfg,
+                             std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+// Execution engine with the "engine" block's "tick_size" (every symbol)
+// and "tick_sizes" ({"SYM": tick}, overriding it per symbol).
+std::unique_ptr<SimpleExecutionEngine> createExecutionEngine(const nlohmann::json &engineCfg);
@@ -1,9 +1,13 @@
 #pragma once
 
 #include <cstddef>
+#include <limits>
+#include <stdexcept>
 #include "TradingTypes.hpp"
 
 class BacktestEngine;
+class CheckpointWriter;
+class CheckpointReader;
 
 class Strategy_I
 {
@@ -16,4 +20,30 @@ public:
                      BacktestEngine &engine)
     = 0;
   virtual void onEnd(BacktestEngine &engine) = 0;
+
+  static constexpr std::size_t unboundedWarmup = std::numeric_limits<std::size_t>::max();
+
+  // Number of bars after which the strategy's state no longer depends on
+  // anything older. Strategies that declare a bounded warmup can be run
+  // segment-parallel (see SegmentedBacktest).
+  virtual std::size_t warmupBars() const { return unboundedWarmup; }
+
+  // Candle fields onBar reads (see BarFields). The engine itself only
+  // needs the close.
+  virtual BarFields barFields() const { return BarField::All; }
+
+  // Checkpoint hooks. saveState must capture everything onBar depends on;
+  // loadState is called right after onStart when an engine resumes, so a
+  // resumed run behaves exactly like one that never stopped.
+  virtual void saveState(CheckpointWriter &out) const
+  {
+    (void)out;
+    throw std::runtime_error("Strategy does not support checkpointing");
+  }
+
+  virtual void loadState(CheckpointReader &in)
+  {
+    (void)in;
+    throw std::runtime_error("Strategy does not support checkpointing");
+  }
 };
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "AllocTracker.hpp"
+#include "BarColumns.hpp"
+#include "ExecutionEngine_I.hpp"
+#include "TradingTypes.hpp"
+
+struct SweepResult
+{
+  nlohmann::json params;
+  Report report;
+  double finalEquity{};
+  std::size_t trades{};
+  AllocStats allocs; // heap allocations of the run (tracking builds only)
+};
+
+// Runs one strategy over one symbol's history for every point of a
+// parameter grid. Array-valued entries of stratCfg["params"] are the grid
+// axes; scalar entries are shared by every point.
+//
+// Runs are small and numerous, so per-run allocations matter: each worker
+// owns a RunArena that every engine, portfolio and strategy it builds
+// allocates from, and the arena is reset (not freed) between runs.
+//
+// With DataPrecision::Float32 the history is kept as float columns
+// instead of candles and every run streams only the columns its
+// strategy reads; bars are widened to double as they are fed.
+//
+// makeExecution builds each run's execution engine (the configured tick
+// sizes, say); it is called from every worker thread. Without it runs use
+// a plain SimpleExecutionEngine.
+class SweepRunner
+{
+public:
+  using ExecutionMaker = std::function<std::unique_ptr<ExecutionEngine_I>()>;
+
+  SweepRunner(std::vector<Candle> candles,
+              const nlohmann::json &stratCfg,
+              double initialCash,
+              DataPrecision precision = DataPrecision::Float64,
+              ExecutionMaker makeExecution = {});
+
+  // Cartesian product of the array-valued params, varying the last
+  // parameter name (in sorted order) fastest.
+  static std::vector<nlohmann::json> expandGrid(const nlohmann::json &stratCfg);
+
+  std::size_t size() const { return configs_.size(); }
+
+  // Results are in grid order. threads == 0 uses every hardware thread.
+  // useArenas = false allocates from the default heap (for comparison).
+  std::vector<SweepResult> run(std::size_t threads = 0, bool useArenas = true) const;
+
+private:
+  SweepResult runOne(const nlohmann::json &stratCfg,
+                     std::pmr::memory_resource *resource) const;
+
+  std::vector<Candle> candles_;         // Float64
+  BasicBarColumns<float> columns32_;   // Float32
+  DataPrecision precision_;
+  std::string symbol_;
+  std::vector<nlohmann::json> configs_;
+  double initialCash_;
+  ExecutionMaker makeExecution_;
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <utility>
+
+// ============================================================
+// Timestamp conversion
+// ============================================================
+//
+// Candles carry ISO-8601 strings ("YYYY-MM-DD" or
+// "YYYY-MM-DD HH:MM:SS"). Hot paths that need to compare or store
+// timestamps compactly convert them to seconds since the Unix epoch (UTC).
+
+// Accepts exactly "YYYY-MM-DD", "YYYY-MM-DD HH:MM" and "YYYY-MM-DD HH:MM:SS"
+// with every field in range; throws std::invalid_argument otherwise.
+std::int64_t parseTimestamp(const std::string &ts);
+
+// Inverse of parseTimestamp. Midnight values are printed as a bare date,
+// matching the daily data the engine is fed.
+std::string formatTimestamp(std::int64_t seconds);
+
+// Same, into `out`, reusing its capacity so per-bar callers do not allocate.
+void formatTimestamp(std::int64_t seconds, std::string &out);
+
+// ============================================================
+// Time ranges
+// ============================================================
+
+// Closed interval of epoch seconds; the defaults leave either side open.
+struct TimeRange
+{
+  std::int64_t start = std::numeric_limits<std::int64_t>::min();
+  std::int64_t end = std::numeric_limits<std::int64_t>::max();
+
+  bool contains(std::int64_t t) const { return t >= start && t <= end; }
+  bool bounded() const
+  {
+    return start != std::numeric_limits<std::int64_t>::min()
+           || end != std::numeric_limits<std::int64_t>::max();
+  }
+};
+
+// Parses config bounds ("" leaves a side open). A bare-date end covers the
+// whole day.
+TimeRange parseTimeRange(const std::string &start, const std::string &end);
+
+// Rows [first, last) of a sorted time column inside `range`, cut to the
+// last `lookbackBars` of those (<= 0: all). Binary search, no scan.
+std::pair<std::size_t, std::size_t> selectRows(const std::int64_t *time, std::size_t count,
+                                               const TimeRange &range, int lookbackBars);
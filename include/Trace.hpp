@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// ============================================================
+// Timeline tracing (Chrome trace event format)
+// ============================================================
+//
+// TraceScope records a named span on the calling thread. Each thread
+// writes its spans into its own fixed-size ring, so recording takes no
+// lock: two clock reads and a handful of stores. A full ring overwrites
+// its oldest spans. While tracing is off (the default) a scope costs one
+// atomic load, a plain load on x86.
+//
+// writeChromeTrace() produces JSON for chrome://tracing or
+// ui.perfetto.dev, one track per thread. Call it once the traced work has
+// finished; spans still being recorded at that moment may be missing.
+
+class Trace
+{
+public:
+  // Starts recording; rings are created with this many spans per thread.
+  static void enable(std::size_t spansPerThread = 1u << 16);
+  static bool enabled() { return enabled_.load(std::memory_order_acquire); }
+
+  // Track name of the calling thread in the viewer.
+  static void setThreadName(const std::string &name);
+
+  static void writeChromeTrace(std::ostream &out);
+  static void writeChromeTrace(const std::string &path);
+
+  // Nanoseconds since enable().
+  static std::int64_t now();
+  static void record(const char *name, std::int64_t id, std::int64_t start, std::int64_t end);
+
+private:
+  inline static std::atomic<bool> enabled_{ false };
+};
+
+// `name` must outlive the trace (a string literal); `id` (a run, segment
+// or symbol index) is shown as an argument when non-negative.
+class TraceScope
+{
+public:
+  explicit TraceScope(const char *name, std::int64_t id = -1)
+    : name_(name), id_(id), start_(Trace::enabled() ? Trace::now() : -1) {}
+
+  ~TraceScope()
+  {
+    if(start_ >= 0)
+    {
+      Trace::record(name_, id_, start_, Trace::now());
+    }
+  }
+
+  TraceScope(const TraceScope &) = delete;
+  TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+  const char *name_;
+  std::int64_t id_;
+  std::int64_t start_;
+};
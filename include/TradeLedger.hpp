@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "TradingTypes.hpp"
+
+// Fixed-size, trivially copyable form of a fill. Symbols are interned to
+// ids and timestamps stored as epoch seconds so a record is 48 bytes and
+// can be written to disk as-is.
+struct TradeRecord
+{
+  std::int64_t timestamp{};
+  double price{};
+  double fees{};
+  double realizedPnL{};
+  std::uint32_t symbolId{};
+  std::int32_t quantity{}; // signed: >0 adds to the position, <0 reduces it
+  std::uint8_t side{};     // OrderSide
+  std::uint8_t reserved[7]{};
+};
+
+struct SymbolPnL
+{
+  std::string symbol;
+  double realizedPnL{};
+  double fees{};
+  std::size_t trades{};
+};
+
+struct HoldingPeriod
+{
+  std::string symbol;
+  std::int64_t opened{}; // epoch seconds
+  std::int64_t closed{}; // epoch seconds; 0 while still open
+  int maxQuantity{};     // largest absolute position during the holding
+};
+
+// Append-only list of every fill of a run. Records live in fixed-size
+// chunks; once the chunks in memory exceed the memory limit, the full
+// chunks are appended to a binary spill file and their memory is reused.
+// Queries stream the spill file followed by the in-memory tail.
+class TradeLedger
+{
+public:
+  explicit TradeLedger(std::size_t memoryLimitBytes = 64u << 20,
+                       std::string spillPath = {},
+                       std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+  void record(const Fill &fill, double realizedPnL);
+
+  std::size_t size() const { return spilled_ + inMemory(); }
+  const std::string &symbol(std::uint32_t id) const { return symbols_[id]; }
+
+  // Calls fn(const TradeRecord &) for every record in fill order.
+  template <typename Fn>
+  void forEach(Fn &&fn) const;
+
+  std::vector<SymbolPnL> pnlBySymbol() const;
+  std::vector<HoldingPeriod> holdingPeriods() const;
+
+private:
+  static constexpr std::size_t chunkRecords = 4096;
+  using Chunk = std::pmr::vector<TradeRecord>;
+
+  std::size_t inMemory() const;
+  void spill();
+  std::ifstream openSpilled() const;
+  void readSpilled(std::ifstream &in, std::vector<TradeRecord> &buffer, std::size_t offset) const;
+
+  std::size_t memoryLimitBytes_;
+  std::string spillPath_;
+  mutable std::ofstream spillOut_;
+
+  std::pmr::vector<Chunk> chunks_;
+  std::pmr::vector<Chunk> spare_;
+  std::size_t tailCount_{ chunkRecords };
+  std::size_t spilled_{};
+
+  std::pmr::vector<std::string> symbols_;
+  std::pmr::unordered_map<std::string, std::uint32_t> ids_;
+};
+
+template <typename Fn>
+void TradeLedger::forEach(Fn &&fn) const
+{
+  if(spilled_ > 0)
+  {
+    std::ifstream in = openSpilled();
+    std::vector<TradeRecord> buffer;
+    for(std::size_t offset = 0; offset < spilled_; offset += chunkRecords)
+    {
+      readSpilled(in, buffer, offset);
+      for(const auto &r : buffer)
+      {
+        fn(r);
+      }
+    }
+  }
+
+  for(std::size_t c = 0; c < chunks_.size(); ++c)
+  {
+    const std::size_t count = (c + 1 == chunks_.size()) ? tailCount_ : chunkRecords;
+    for(std::size_t i = 0; i < count; ++i)
+    {
+      fn(chunks_[c][i]);
+    }
+  }
+}
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 
+#include "Money.hpp"
+
 // ============================================================
 // Enums
 // ============================================================
@@ -39,6 +42,21 @@ struct Candle
   double volume{};
 };
 
+// Set of Candle price/volume fields, for column projection: strategies
+// declare the fields they read and columnar feeds decode only those (the
+// rest read as 0). Timestamp and symbol are always filled.
+using BarFields = std::uint8_t;
+
+namespace BarField
+{
+constexpr BarFields Open = 1 << 0;
+constexpr BarFields High = 1 << 1;
+constexpr BarFields Low = 1 << 2;
+constexpr BarFields Close = 1 << 3;
+constexpr BarFields Volume = 1 << 4;
+constexpr BarFields All = Open | High | Low | Close | Volume;
+} // namespace BarField
+
 struct Order
 {
   std::string symbol;
@@ -54,8 +72,8 @@ struct Fill
   std::string symbol;
   int quantity{};
   OrderSide side{ OrderSide::Buy };
-  double price{};
-  double fees{};
+  Money price{};
+  Money fees{};
   std::string timestamp;
 };
 
@@ -63,8 +81,9 @@ struct Position
 {
   std::string symbol;
   int quantity{}; // >0 long, <0 short
-  double avgPrice{};
-  double unrealizedPnL{};
+  Money avgPrice{};
+  Money unrealizedPnL{};
+  Money realizedPnL{}; // cumulative over the position's life, before fees
 };
 
 struct Snapshot
@@ -82,4 +101,6 @@ struct Report
   double maxDrawdown{};
   double sharpe{};
   double cagr{};
+  double realizedPnL{};
+  double unrealizedPnL{};
 };
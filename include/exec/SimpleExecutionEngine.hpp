@@ -1,5 +1,7 @@
 #pragma once
 
+#include <string>
+#include <unordered_map>
 #include "ExecutionEngine_I.hpp"
 
 class SimpleExecutionEngine : public ExecutionEngine_I
@@ -7,4 +9,15 @@ class SimpleExecutionEngine : public ExecutionEngine_I
 public:
   std::optional<Fill>
   execute(const Order &order, const Candle &bar) override;
+
+  // Fills are priced at the bar's close rounded to the symbol's tick size
+  // (the default tick when it has none). A tick of 0, the default, leaves
+  // the close unrounded.
+  void setDefaultTickSize(double tick) { defaultTick_ = tick; }
+  void setTickSize(const std::string &symbol, double tick) { ticks_[symbol] = tick; }
+  double tickSize(const std::string &symbol) const;
+
+private:
+  double defaultTick_ = 0.0;
+  std::unordered_map<std::string, double> ticks_;
 };
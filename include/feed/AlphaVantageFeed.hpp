@@ -4,7 +4,9 @@
 #include <string>
 #include <vector>
 
+#include "CandleStore.hpp"
 #include "DataFeed_I.hpp"
+#include "HttpFetcher.hpp"
 #include "TradingTypes.hpp"
 
 class AlphaVantageFeed : public DataFeed_I
@@ -14,6 +16,7 @@ public:
 
   bool hasNext() const override;
   const Candle &next() override;
+  void skip(std::size_t count) override;
 
   std::size_t currentIndex() const;
 
@@ -22,6 +25,53 @@ private:
   std::size_t index_;
 };
 
+struct AlphaVantageOptions
+{
+  // Point at a local stand-in server for testing.
+  std::string baseUrl{ "https://www.alphavantage.co" };
+  // "compact" (the latest 100 bars) or "full" history.
+  std::string outputSize{ "compact" };
+  // The free tier allows 5 requests per minute.
+  HttpFetchOptions http{ 8, 5.0 };
+};
+
+// Fetches every symbol concurrently over shared connections; one series
+// per symbol, in order. Throws std::runtime_error naming the first symbol
+// that failed.
+std::vector<std::vector<Candle>>
+fetchAlphaVantageSeries(const std::string &apiKey,
+                        const std::vector<std::string> &symbols,
+                        int lookbackBars,
+                        const AlphaVantageOptions &options = {});
+
+struct StoreUpdateStats
+{
+  std::size_t compactRequests{};
+  std::size_t fullRequests{};
+  std::size_t barsAdded{};
+  std::size_t bytesParsed{};
+};
+
+// Brings every symbol in the store up to date: symbols whose newest bar
+// is recent get a compact request, new or stale ones a full one, and only
+// bars from the newest stored date on are merged in.
+StoreUpdateStats updateAlphaVantageStore(CandleStore &store,
+                                         const std::string &apiKey,
+                                         const std::vector<std::string> &symbols,
+                                         const AlphaVantageOptions &options = {});
+
+std::vector<Candle>
+fetchAlphaVantageCandles(const std::string &apiKey,
+                         const std::string &symbol,
+                         int lookbackBars);
+
+// Candles of a TIME_SERIES_DAILY response, oldest first, trimmed to the
+// last `lookbackBars` (<= 0: all).
+std::vector<Candle>
+parseAlphaVantageCandles(const std::string &raw,
+                         const std::string &symbol,
+                         int lookbackBars);
+
 std::unique_ptr<DataFeed_I>
 makeAlphaVantageFeed(const std::string &apiKey,
                      const std::string &symbol,
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+
+#include "BarColumns.hpp"
+#include "DataFeed_I.hpp"
+#include "TradingTypes.hpp"
+
+// Non-owning feed over one symbol's bar columns, which must outlive it.
+// Each bar is widened into one reused Candle when next() reaches it, so a
+// returned bar stays valid until the next call. Only the columns in
+// `fields` are read (the other fields stay 0), so a close-only run over
+// float columns streams 12 bytes per bar. Instantiated for float and
+// double.
+template <typename Scalar>
+class BarColumnsFeed : public DataFeed_I
+{
+public:
+  explicit BarColumnsFeed(const BasicBarColumns<Scalar> &bars,
+                          BarFields fields = BarField::All);
+
+  bool hasNext() const override { return row_ < bars_.size(); }
+  const Candle &next() override;
+  void skip(std::size_t count) override;
+
+private:
+  const BasicBarColumns<Scalar> &bars_;
+  BarFields fields_;
+  std::size_t row_{};
+  Candle bar_;
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "DataFeed_I.hpp"
+#include "TradingTypes.hpp"
+
+// Non-owning feed over candles that outlive it, so many runs (the points
+// of a parameter sweep, say) can share one copy of the history.
+class CandleViewFeed : public DataFeed_I
+{
+public:
+  CandleViewFeed(const Candle *candles, std::size_t size)
+    : candles_(candles), size_(size) {}
+
+  explicit CandleViewFeed(const std::vector<Candle> &candles)
+    : CandleViewFeed(candles.data(), candles.size()) {}
+
+  bool hasNext() const override { return index_ < size_; }
+  const Candle &next() override { return candles_[index_++]; }
+  void skip(std::size_t count) override { index_ = std::min(size_, index_ + count); }
+
+private:
+  const Candle *candles_;
+  std::size_t size_;
+  std::size_t index_{};
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "DataFeed_I.hpp"
+#include "TradingTypes.hpp"
+
+// Merges N per-symbol, timestamp-sorted candle series into one stream.
+// The merge runs once with a k-way min-heap when the feed is built and
+// the candles are moved into a single contiguous vector, so next() is a
+// sequential walk. Bars sharing a timestamp form one time slice;
+// endOfSlice() marks the last bar of each slice.
+class MergedFeed : public DataFeed_I
+{
+public:
+  explicit MergedFeed(std::vector<std::vector<Candle>> series);
+
+  bool hasNext() const override;
+  const Candle &next() override;
+  void skip(std::size_t count) override;
+  bool endOfSlice() const override;
+
+  std::size_t symbolCount() const { return symbols_.size(); }
+  const std::string &symbol(std::size_t id) const { return symbols_[id]; }
+
+  // Symbol id (index into the constructor's series) of the last bar
+  // returned by next().
+  std::size_t lastSymbolId() const;
+
+  std::size_t size() const { return candles_.size(); }
+
+private:
+  // Symbol id with the end-of-slice flag packed into the top bit.
+  static constexpr std::uint32_t sliceEndBit = 0x80000000u;
+
+  std::vector<Candle> candles_;
+  std::vector<std::uint32_t> tags_;
+  std::vector<std::string> symbols_;
+  std::size_t index_{};
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "DataFeed_I.hpp"
+#include "SpscRing.hpp"
+#include "TradingTypes.hpp"
+
+// Decorator that pulls bars from another feed on a background thread.
+// The worker decodes the next block of bars into one buffer while the
+// engine consumes the other; filled and drained buffers are handed over
+// through lock-free SPSC rings, so reading and decoding overlap with
+// strategy compute. Bars returned by next() stay valid until the
+// following call to next().
+class PrefetchingFeed : public DataFeed_I
+{
+public:
+  explicit PrefetchingFeed(std::unique_ptr<DataFeed_I> inner,
+                           std::size_t blockSize = 4096);
+  ~PrefetchingFeed() override;
+
+  PrefetchingFeed(const PrefetchingFeed &) = delete;
+  PrefetchingFeed &operator=(const PrefetchingFeed &) = delete;
+
+  bool hasNext() const override;
+  const Candle &next() override;
+  bool endOfSlice() const override;
+
+private:
+  struct Block
+  {
+    std::vector<Candle> bars;
+    std::vector<std::uint8_t> sliceEnds;
+    std::size_t count{};
+    bool last{};
+    std::exception_ptr error;
+  };
+
+  static constexpr std::size_t blockCount = 2;
+
+  void produce();
+  Block *waitForFilled() const;
+
+  std::unique_ptr<DataFeed_I> inner_;
+  std::size_t blockSize_;
+  std::array<Block, blockCount> blocks_;
+
+  mutable SpscRing<Block *, blockCount> filled_;
+  SpscRing<Block *, blockCount> free_;
+
+  Block *current_{};
+  std::size_t pos_{};
+
+  std::atomic<bool> stop_{ false };
+  std::thread worker_;
+};
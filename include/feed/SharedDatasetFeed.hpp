@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "DataFeed_I.hpp"
+#include "SharedDataset.hpp"
+#include "Timestamp.hpp"
+#include "TradingTypes.hpp"
+
+// Read-only feed over symbols of a SharedDataset. Nothing is copied up
+// front: each bar is decoded from the shared columns when next() reaches
+// it, into one Candle per symbol, so a returned bar stays valid until the
+// next bar of the same symbol. Several symbols are merged by timestamp as
+// the feed advances (ties in the order the ids were given), and
+// endOfSlice() marks the last bar of each timestamp, as in MergedFeed.
+class SharedDatasetFeed : public DataFeed_I
+{
+public:
+  // Only the last `lookbackBars` bars (<= 0: all) of each symbol within
+  // `range` are fed, and only the columns in `fields` are read (the other
+  // fields stay 0).
+  SharedDatasetFeed(std::shared_ptr<const SharedDataset> dataset,
+                    const std::vector<std::size_t> &ids,
+                    int lookbackBars = 0,
+                    const TimeRange &range = {},
+                    BarFields fields = BarField::All);
+
+  bool hasNext() const override { return !heap_.empty(); }
+  const Candle &next() override;
+  void skip(std::size_t count) override;
+  bool endOfSlice() const override { return endOfSlice_; }
+
+  // Bars left to feed.
+  std::size_t remaining() const;
+
+private:
+  struct Cursor
+  {
+    const SharedDataset::Series *series;
+    std::size_t row;
+    std::size_t end; // one past the last row to feed
+    Candle bar;
+  };
+
+  std::int64_t nextTime(std::uint32_t c) const
+  {
+    return cursors_[c].series->time[cursors_[c].row];
+  }
+
+  // Heap order: earlier bars first, ties by cursor index.
+  bool later(std::uint32_t a, std::uint32_t b) const
+  {
+    return nextTime(a) != nextTime(b) ? nextTime(a) > nextTime(b) : a > b;
+  }
+
+  // Moves the cursor with the earliest next bar past it; returns the
+  // cursor and the row it was on.
+  std::pair<Cursor *, std::size_t> advance();
+
+  std::shared_ptr<const SharedDataset> dataset_;
+  std::vector<Cursor> cursors_;
+  std::vector<std::uint32_t> heap_; // cursors with bars left, earliest first
+  BarFields fields_;
+  bool endOfSlice_{ true };
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "CrossSectionalStrategy_I.hpp"
+#include "feed/MergedFeed.hpp"
+
+// Groups a MergedFeed into time slices and exposes each slice as SoA
+// columns over the whole universe, for the cross-sectional engine mode.
+class UniverseFeed
+{
+public:
+  explicit UniverseFeed(std::unique_ptr<MergedFeed> merged);
+
+  bool hasNext() const { return merged_->hasNext(); }
+
+  // Advance to the next timestamp and refresh the SoA columns.
+  const UniverseView &nextSlice();
+
+  const UniverseView &view() const { return view_; }
+
+  std::size_t size() const { return symbols_.size(); }
+  const std::vector<std::string> &symbols() const { return symbols_; }
+
+  // Symbol id for a ticker, or size() when it is not in the universe.
+  std::size_t idOf(const std::string &symbol) const;
+
+  // Bar of symbol `id` in the current slice, or nullptr if it has none.
+  const Candle *bar(std::size_t id) const;
+
+private:
+  std::unique_ptr<MergedFeed> merged_;
+  std::vector<std::string> symbols_;
+  std::unordered_map<std::string, std::size_t> ids_;
+
+  std::vector<double> close_;
+  std::vector<double> volume_;
+  std::vector<std::uint8_t> valid_;
+  std::vector<const Candle *> bars_;
+  std::vector<std::size_t> touched_;
+  std::string timestamp_;
+  UniverseView view_;
+};
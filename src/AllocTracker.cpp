@@ -0,0 +1,364 @@
+#include "AllocTracker.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+
+#if BACKTEST_ALLOC_TRACKING
+#include <cstdio>
+#include <cstdlib>
+#include <execinfo.h>
+#include <new>
+#include <unistd.h>
+#endif
+
+std::uint64_t AllocStats::totalCount() const
+{
+  std::uint64_t total = 0;
+  for(std::uint64_t c : count)
+  {
+    total += c;
+  }
+  return total;
+}
+
+std::uint64_t AllocStats::totalBytes() const
+{
+  std::uint64_t total = 0;
+  for(std::uint64_t b : bytes)
+  {
+    total += b;
+  }
+  return total;
+}
+
+AllocStats &AllocStats::operator+=(const AllocStats &other)
+{
+  for(std::size_t i = 0; i < enginePhaseCount; ++i)
+  {
+    count[i] += other.count[i];
+    bytes[i] += other.bytes[i];
+  }
+  return *this;
+}
+
+AllocStats &AllocStats::operator-=(const AllocStats &other)
+{
+  for(std::size_t i = 0; i < enginePhaseCount; ++i)
+  {
+    count[i] -= other.count[i];
+    bytes[i] -= other.bytes[i];
+  }
+  return *this;
+}
+
+void writeAllocReport(std::ostream &out, const AllocStats &stats)
+{
+  for(std::size_t i = 0; i < enginePhaseCount; ++i)
+  {
+    if(stats.count[i] == 0)
+    {
+      continue;
+    }
+    out << "  " << std::left << std::setw(16) << enginePhaseName(static_cast<EnginePhase>(i))
+        << std::right << std::setw(10) << stats.count[i] << " allocs "
+        << std::setw(14) << stats.bytes[i] << " bytes\n";
+  }
+  out << "  " << std::left << std::setw(16) << "total"
+      << std::right << std::setw(10) << stats.totalCount() << " allocs "
+      << std::setw(14) << stats.totalBytes() << " bytes\n";
+}
+
+namespace
+{
+
+std::atomic<bool> strictMode{ false };
+
+} // namespace
+
+void AllocTracker::setStrict(bool on)
+{
+  strictMode.store(on, std::memory_order_relaxed);
+}
+
+bool AllocTracker::strict()
+{
+  return strictMode.load(std::memory_order_relaxed);
+}
+
+#if BACKTEST_ALLOC_TRACKING
+
+namespace
+{
+
+// Plain data so it is usable from operator new at any point of a
+// thread's life, including before and after its thread_local objects.
+struct ThreadState
+{
+  AllocStats stats;
+  EnginePhase phase{ EnginePhase::Outside };
+  int trapDepth{};
+  int allowDepth{};
+  bool reporting{};
+};
+
+thread_local ThreadState threadState;
+
+std::atomic<std::uint64_t> exitedCount[enginePhaseCount];
+std::atomic<std::uint64_t> exitedBytes[enginePhaseCount];
+
+// Folds a thread's counters into the process totals when it exits.
+struct ExitFlush
+{
+  ~ExitFlush()
+  {
+    for(std::size_t i = 0; i < enginePhaseCount; ++i)
+    {
+      exitedCount[i].fetch_add(threadState.stats.count[i], std::memory_order_relaxed);
+      exitedBytes[i].fetch_add(threadState.stats.bytes[i], std::memory_order_relaxed);
+    }
+  }
+};
+
+thread_local ExitFlush exitFlush;
+
+[[noreturn]] void trap(std::size_t size)
+{
+  // backtrace_symbols_fd writes straight to the fd, so nothing here
+  // allocates through the hooks again.
+  char line[160];
+  int n = std::snprintf(line, sizeof(line),
+                        "FATAL: %zu-byte heap allocation in the steady-state bar loop "
+                        "(phase: %s); backtrace:\n",
+                        size, enginePhaseName(threadState.phase));
+  if(n > 0)
+  {
+    ssize_t written = ::write(STDERR_FILENO, line, static_cast<std::size_t>(n));
+    (void)written;
+  }
+
+  void *frames[64];
+  int depth = ::backtrace(frames, 64);
+  ::backtrace_symbols_fd(frames, depth, STDERR_FILENO);
+  std::abort();
+}
+
+void count(std::size_t size)
+{
+  ThreadState &state = threadState;
+  const auto phase = static_cast<std::size_t>(state.phase);
+  ++state.stats.count[phase];
+  state.stats.bytes[phase] += size;
+
+  if(state.trapDepth > 0 && state.allowDepth == 0 && !state.reporting
+     && strictMode.load(std::memory_order_relaxed))
+  {
+    state.reporting = true;
+    trap(size);
+  }
+}
+
+void *allocate(std::size_t size)
+{
+  count(size);
+  void *p = std::malloc(size > 0 ? size : 1);
+  if(p == nullptr)
+  {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void *allocateAligned(std::size_t size, std::align_val_t alignment)
+{
+  count(size);
+  const auto align = static_cast<std::size_t>(alignment);
+  void *p = nullptr;
+  if(::posix_memalign(&p, std::max(align, sizeof(void *)), size > 0 ? size : 1) != 0)
+  {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+} // namespace
+
+AllocStats AllocTracker::threadStats()
+{
+  (void)&exitFlush; // odr-use so the thread registers its exit flush
+  return threadState.stats;
+}
+
+AllocStats AllocTracker::processStats()
+{
+  AllocStats stats = threadStats();
+  for(std::size_t i = 0; i < enginePhaseCount; ++i)
+  {
+    stats.count[i] += exitedCount[i].load(std::memory_order_relaxed);
+    stats.bytes[i] += exitedBytes[i].load(std::memory_order_relaxed);
+  }
+  return stats;
+}
+
+AllocPhaseScope::AllocPhaseScope(EnginePhase phase)
+  : previous_(threadState.phase)
+{
+  (void)&exitFlush;
+  threadState.phase = phase;
+}
+
+AllocPhaseScope::~AllocPhaseScope()
+{
+  threadState.phase = previous_;
+}
+
+void AllocPhaseScope::enter(EnginePhase phase)
+{
+  threadState.phase = phase;
+}
+
+AllocTrapScope::AllocTrapScope()
+{
+  ++threadState.trapDepth;
+}
+
+AllocTrapScope::~AllocTrapScope()
+{
+  --threadState.trapDepth;
+}
+
+AllocAllowScope::AllocAllowScope()
+{
+  ++threadState.allowDepth;
+}
+
+AllocAllowScope::~AllocAllowScope()
+{
+  --threadState.allowDepth;
+}
+
+// ---- Global allocation hooks ----
+
+void *operator new(std::size_t size)
+{
+  return allocate(size);
+}
+
+void *operator new[](std::size_t size)
+{
+  return allocate(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+  try
+  {
+    return allocate(size);
+  }
+  catch(...)
+  {
+    return nullptr;
+  }
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+  try
+  {
+    return allocate(size);
+  }
+  catch(...)
+  {
+    return nullptr;
+  }
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment)
+{
+  return allocateAligned(size, alignment);
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment)
+{
+  return allocateAligned(size, alignment);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment,
+                   const std::nothrow_t &) noexcept
+{
+  try
+  {
+    return allocateAligned(size, alignment);
+  }
+  catch(...)
+  {
+    return nullptr;
+  }
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment,
+                     const std::nothrow_t &) noexcept
+{
+  try
+  {
+    return allocateAligned(size, alignment);
+  }
+  catch(...)
+  {
+    return nullptr;
+  }
+}
+
+void operator delete(void *p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept
+{
+  std::free(p);
+}
+
+void operator delete[](void *p, std::align_val_t) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept
+{
+  std::free(p);
+}
+
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept
+{
+  std::free(p);
+}
+
+#else
+
+AllocStats AllocTracker::threadStats()
+{
+  return {};
+}
+
+AllocStats AllocTracker::processStats()
+{
+  return {};
+}
+
+#endif
@@ -1,10 +1,13 @@
 #include "feed/AlphaVantageFeed.hpp"
+#include "Log.hpp"
+#include "Timestamp.hpp"
+#include "Trace.hpp"
 
-#include <curl/curl.h>
 #include <nlohmann/json.hpp>
 
 #include <algorithm>
-#include <iostream>
+#include <chrono>
+#include <optional>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -12,102 +15,191 @@
 
 using nlohmann::json;
 
-namespace
+AlphaVantageFeed::AlphaVantageFeed(std::vector<Candle> candles)
+  : candles_(std::move(candles)), index_(0)
 {
+}
 
-size_t writeCallback(char *ptr, size_t size, size_t nmemb, void *userdata)
+bool AlphaVantageFeed::hasNext() const
 {
-  std::size_t totalSize = size * nmemb;
-  auto *buffer = static_cast<std::string *>(userdata);
-  buffer->append(ptr, totalSize);
-  return totalSize;
+  return index_ < candles_.size();
 }
 
-std::string httpGet(const std::string &url)
+const Candle &AlphaVantageFeed::next()
 {
-  CURL *curl = curl_easy_init();
-  if(curl == nullptr)
+  if(!hasNext())
   {
-    throw std::runtime_error("Failed to initialize CURL");
+    throw std::out_of_range("AlphaVantageFeed::next called with no more data");
   }
+  return candles_[index_++];
+}
+
+void AlphaVantageFeed::skip(std::size_t count)
+{
+  index_ = std::min(candles_.size(), index_ + count);
+}
 
-  std::string response;
+std::size_t AlphaVantageFeed::currentIndex() const
+{
+  return index_;
+}
 
-  curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
-  curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-  curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+namespace
+{
 
-  curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 1L);
-  curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 2L);
-  curl_easy_setopt(curl, CURLOPT_CAINFO, "/etc/ssl/certs/ca-certificates.crt");
-  curl_easy_setopt(curl, CURLOPT_CAPATH, "/etc/ssl/certs");
+// A compact response holds the latest 100 bars.
+constexpr std::size_t compactBars = 100;
 
-  CURLcode res = curl_easy_perform(curl);
-  if(res != CURLE_OK)
+std::vector<HttpResponse> fetchDaily(const std::string &apiKey,
+                                     const std::vector<std::string> &symbols,
+                                     const std::vector<bool> &full,
+                                     const AlphaVantageOptions &options)
+{
+  std::vector<std::string> urls;
+  urls.reserve(symbols.size());
+  for(std::size_t i = 0; i < symbols.size(); ++i)
   {
-    std::string msg = "CURL error: ";
-    msg += curl_easy_strerror(res);
-    curl_easy_cleanup(curl);
-    throw std::runtime_error(msg);
+    std::ostringstream url;
+    url << options.baseUrl << "/query?function=TIME_SERIES_DAILY"
+        << "&symbol=" << symbols[i]
+        << "&outputsize=" << (full[i] ? "full" : "compact")
+        << "&apikey=" << apiKey;
+    urls.push_back(url.str());
   }
 
-  long httpCode = 0;
-  curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &httpCode);
-  curl_easy_cleanup(curl);
-
-  if(httpCode != 200)
+  TraceScope trace("fetch candles", static_cast<std::int64_t>(symbols.size()));
+  HttpFetcher fetcher(options.http);
+  std::vector<HttpResponse> responses = fetcher.fetchAll(urls);
+  for(std::size_t i = 0; i < symbols.size(); ++i)
   {
-    std::ostringstream oss;
-    oss << "HTTP error code " << httpCode;
-    throw std::runtime_error(oss.str());
+    if(!responses[i].ok())
+    {
+      throw std::runtime_error("Fetching " + symbols[i] + " failed: " + responses[i].error);
+    }
   }
-
-  return response;
+  return responses;
 }
 
 } // namespace
 
-AlphaVantageFeed::AlphaVantageFeed(std::vector<Candle> candles)
-  : candles_(std::move(candles)), index_(0)
+std::vector<std::vector<Candle>>
+fetchAlphaVantageSeries(const std::string &apiKey,
+                        const std::vector<std::string> &symbols,
+                        int lookbackBars,
+                        const AlphaVantageOptions &options)
 {
-}
+  BACKTEST_LOG(Info,
+               "Fetching data from Alpha Vantage for {} symbol(s) (TIME_SERIES_DAILY, "
+               "lookback_bars={})...",
+               symbols.size(), lookbackBars);
 
-bool AlphaVantageFeed::hasNext() const
-{
-  return index_ < candles_.size();
+  const bool full = options.outputSize == "full";
+  if(!full && (lookbackBars <= 0 || static_cast<std::size_t>(lookbackBars) > compactBars))
+  {
+    BACKTEST_LOG(Warn, "Compact responses hold the last {} bars; set \"output_size\": "
+                       "\"full\" or use a store for more history",
+                 compactBars);
+  }
+
+  std::vector<HttpResponse> responses =
+    fetchDaily(apiKey, symbols, std::vector<bool>(symbols.size(), full), options);
+
+  std::vector<std::vector<Candle>> series;
+  series.reserve(symbols.size());
+  for(std::size_t i = 0; i < symbols.size(); ++i)
+  {
+    series.push_back(parseAlphaVantageCandles(responses[i].body, symbols[i], lookbackBars));
+  }
+  return series;
 }
 
-const Candle &AlphaVantageFeed::next()
+StoreUpdateStats updateAlphaVantageStore(CandleStore &store,
+                                         const std::string &apiKey,
+                                         const std::vector<std::string> &symbols,
+                                         const AlphaVantageOptions &options)
 {
-  if(!hasNext())
+  const std::int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+                             std::chrono::system_clock::now().time_since_epoch())
+                             .count();
+
+  // Decide per symbol from its newest stored bar. The bar count of a gap
+  // is estimated from weekdays, with room for holidays and the revised
+  // last bar; a compact response that still falls short is redone in full.
+  std::vector<std::optional<std::int64_t>> last(symbols.size());
+  std::vector<bool> full(symbols.size());
+  for(std::size_t i = 0; i < symbols.size(); ++i)
   {
-    throw std::out_of_range("AlphaVantageFeed::next called with no more data");
+    last[i] = store.lastTime(symbols[i]);
+    const std::int64_t gapDays = last[i] ? (now - *last[i]) / 86400 : 0;
+    full[i] = !last[i] || gapDays * 5 / 7 + 1 > static_cast<std::int64_t>(compactBars) * 4 / 5;
   }
-  return candles_[index_++];
+
+  StoreUpdateStats stats;
+  std::vector<std::size_t> pending(symbols.size());
+  for(std::size_t i = 0; i < symbols.size(); ++i)
+  {
+    pending[i] = i;
+  }
+
+  while(!pending.empty())
+  {
+    std::vector<std::string> batch;
+    std::vector<bool> batchFull;
+    for(std::size_t i : pending)
+    {
+      batch.push_back(symbols[i]);
+      batchFull.push_back(full[i]);
+      ++(full[i] ? stats.fullRequests : stats.compactRequests);
+    }
+    std::vector<HttpResponse> responses = fetchDaily(apiKey, batch, batchFull, options);
+
+    std::vector<std::size_t> retry;
+    for(std::size_t k = 0; k < pending.size(); ++k)
+    {
+      const std::size_t i = pending[k];
+      stats.bytesParsed += responses[k].body.size();
+      std::vector<Candle> bars = parseAlphaVantageCandles(responses[k].body, symbols[i], 0);
+
+      if(last[i])
+      {
+        if(!full[i] && parseTimestamp(bars.front().timestamp) > *last[i])
+        {
+          full[i] = true;
+          retry.push_back(i);
+          continue;
+        }
+
+        // Keep the newest stored bar's date onwards: it may be revised.
+        auto newer = std::find_if(bars.begin(), bars.end(), [&](const Candle &c)
+                                  { return parseTimestamp(c.timestamp) >= *last[i]; });
+        bars.erase(bars.begin(), newer);
+      }
+      stats.barsAdded += store.merge(symbols[i], bars);
+    }
+    pending = std::move(retry);
+  }
+
+  BACKTEST_LOG(Info,
+               "Updated candle store {}: {} compact and {} full request(s), {} new bar(s), "
+               "{} KiB parsed",
+               store.directory(), stats.compactRequests, stats.fullRequests, stats.barsAdded,
+               stats.bytesParsed >> 10);
+  return stats;
 }
 
-std::size_t AlphaVantageFeed::currentIndex() const
+std::vector<Candle>
+fetchAlphaVantageCandles(const std::string &apiKey,
+                         const std::string &symbol,
+                         int lookbackBars)
 {
-  return index_;
+  return std::move(fetchAlphaVantageSeries(apiKey, { symbol }, lookbackBars).front());
 }
 
-std::unique_ptr<DataFeed_I>
-makeAlphaVantageFeed(const std::string &apiKey,
-                     const std::string &symbol,
-                     int lookbackBars)
+std::vector<Candle>
+parseAlphaVantageCandles(const std::string &raw,
+                         const std::string &symbol,
+                         int lookbackBars)
 {
-  std::cout << "Fetching data from Alpha Vantage for " << symbol
-            << " (TIME_SERIES_DAILY, lookback_bars=" << lookbackBars << ")...\n";
-
-  std::ostringstream url;
-  url << "https://www.alphavantage.co/query?function=TIME_SERIES_DAILY"
-      << "&symbol=" << symbol
-      << "&outputsize=compact"
-      << "&apikey=" << apiKey;
-
-  std::string raw = httpGet(url.str());
-
   json j;
   try
   {
@@ -182,9 +274,17 @@ makeAlphaVantageFeed(const std::string &apiKey,
     throw std::runtime_error("Alpha Vantage returned no candles for symbol " + symbol);
   }
 
-  std::cout << "Fetched " << candles.size() << " candles. "
-            << "Date range: " << candles.front().timestamp
-            << " -> " << candles.back().timestamp << "\n";
+  BACKTEST_LOG(Info, "Fetched {} candles for {}. Date range: {} -> {}", candles.size(),
+               symbol, candles.front().timestamp, candles.back().timestamp);
 
-  return std::make_unique<AlphaVantageFeed>(std::move(candles));
+  return candles;
+}
+
+std::unique_ptr<DataFeed_I>
+makeAlphaVantageFeed(const std::string &apiKey,
+                     const std::string &symbol,
+                     int lookbackBars)
+{
+  return std::make_unique<AlphaVantageFeed>(
+    fetchAlphaVantageCandles(apiKey, symbol, lookbackBars));
 }
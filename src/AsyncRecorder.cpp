@@ -0,0 +1,53 @@
+#include "AsyncRecorder.hpp"
+
+AsyncRecorder::AsyncRecorder(Metrics &metrics)
+  : metrics_(metrics),
+    worker_([this] { consume(); })
+{
+}
+
+AsyncRecorder::~AsyncRecorder()
+{
+  finish();
+}
+
+void AsyncRecorder::record(const Snapshot &s)
+{
+  while(!queue_.tryPush(s))
+  {
+    std::this_thread::yield();
+  }
+}
+
+void AsyncRecorder::finish()
+{
+  if(worker_.joinable())
+  {
+    done_.store(true, std::memory_order_release);
+    worker_.join();
+  }
+}
+
+void AsyncRecorder::consume()
+{
+  Snapshot s;
+  for(;;)
+  {
+    if(queue_.tryPop(s))
+    {
+      metrics_.record(s);
+      continue;
+    }
+    if(done_.load(std::memory_order_acquire))
+    {
+      // The producer stopped before setting done_, so one last drain
+      // sees everything it pushed.
+      while(queue_.tryPop(s))
+      {
+        metrics_.record(s);
+      }
+      return;
+    }
+    std::this_thread::yield();
+  }
+}
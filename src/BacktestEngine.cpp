@@ -1,14 +1,146 @@
 #include "BacktestEngine.hpp"
+#include "Checkpoint.hpp"
+#include "AsyncRecorder.hpp"
+#include "Trace.hpp"
+#include "feed/PrefetchingFeed.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+
+constexpr std::uint64_t checkpointMagic = 0x315450434B544231ull; // "1BTKCPT1"
+constexpr std::uint64_t checkpointVersion = 4;
+
+// Per-bar strategies rarely queue more than a few orders per bar; the
+// buffer is sized up front so placing them never allocates in the loop.
+constexpr std::size_t initialOrderCapacity = 16;
+
+// Resources the pipelined recorder thread may allocate from while the
+// simulation thread does too. The default resource is assumed to be the
+// heap.
+bool threadSafeResource(std::pmr::memory_resource *resource)
+{
+  return resource == std::pmr::get_default_resource()
+         || resource == std::pmr::new_delete_resource()
+         || dynamic_cast<std::pmr::synchronized_pool_resource *>(resource) != nullptr;
+}
+
+// Moves the engine thread through the phases of a run: allocation
+// tracking attributes to the current phase, and with hardware counters on
+// the counts between two phase changes are charged to the phase left.
+class PhaseTracker
+{
+public:
+  PhaseTracker(PerfMode mode, PerfReport &report)
+    : alloc_(EnginePhase::Setup), report_(report)
+  {
+    report_ = PerfReport{};
+    report_.mode = mode;
+    if(mode == PerfMode::Off)
+    {
+      return;
+    }
+
+    perf_.emplace();
+    report_.available = perf_->available();
+    report_.events = perf_->events();
+    report_.status = perf_->status();
+    start_ = last_ = perf_->read();
+  }
+
+  void enter(EnginePhase phase)
+  {
+    alloc_.enter(phase);
+    if(report_.mode == PerfMode::Phases && report_.available)
+    {
+      charge(perf_->read());
+    }
+    current_ = phase;
+  }
+
+  void finish(std::size_t bars)
+  {
+    if(!perf_)
+    {
+      return;
+    }
+
+    const PerfSample end = perf_->read();
+    if(report_.mode == PerfMode::Phases)
+    {
+      charge(end);
+    }
+    report_.total = end;
+    report_.total -= start_;
+    report_.bars = bars;
+  }
+
+private:
+  void charge(const PerfSample &now)
+  {
+    PerfSample delta = now;
+    delta -= last_;
+    report_.phase[static_cast<std::size_t>(current_)] += delta;
+    last_ = now;
+  }
+
+  AllocPhaseScope alloc_;
+  PerfReport &report_;
+  std::optional<PerfCounters> perf_;
+  EnginePhase current_{ EnginePhase::Setup };
+  PerfSample start_;
+  PerfSample last_;
+};
+
+} // namespace
 
 BacktestEngine::BacktestEngine(std::unique_ptr<Strategy_I> strategy,
                                std::unique_ptr<ExecutionEngine_I> exec,
                                std::unique_ptr<DataFeed_I> feed,
-                               double initialCash)
-  : strategy_(std::move(strategy)),
+                               double initialCash,
+                               std::pmr::memory_resource *resource)
+  : resource_(resource),
+    pendingOrders_(resource),
+    strategy_(std::move(strategy)),
     exec_(std::move(exec)),
     feed_(std::move(feed)),
-    portfolio_(initialCash)
+    portfolio_(initialCash, resource),
+    metrics_(resource),
+    ledger_(64u << 20, {}, resource),
+    batchBars_(resource),
+    batchFills_(resource)
 {
+  pendingOrders_.reserve(initialOrderCapacity);
+}
+
+BacktestEngine::BacktestEngine(std::unique_ptr<CrossSectionalStrategy_I> strategy,
+                               std::unique_ptr<ExecutionEngine_I> exec,
+                               std::unique_ptr<UniverseFeed> universe,
+                               double initialCash,
+                               std::pmr::memory_resource *resource)
+  : resource_(resource),
+    pendingOrders_(resource),
+    exec_(std::move(exec)),
+    xsStrategy_(std::move(strategy)),
+    universe_(std::move(universe)),
+    portfolio_(initialCash, resource),
+    metrics_(resource),
+    ledger_(64u << 20, {}, resource),
+    batchBars_(resource),
+    batchFills_(resource)
+{
+  portfolio_.bindUniverse(universe_->symbols());
+
+  const std::size_t n = universe_->size();
+  pendingOrders_.reserve(std::max(n, initialOrderCapacity));
+  batchBars_.reserve(n);
+  batchFills_.reserve(n);
 }
 
 void BacktestEngine::placeOrder(const Order &o)
@@ -16,37 +148,396 @@ void BacktestEngine::placeOrder(const Order &o)
   pendingOrders_.push_back(o);
 }
 
+void BacktestEngine::setPipelined(bool enabled, std::size_t decodeBlockBars)
+{
+  if(enabled && xsStrategy_)
+  {
+    throw std::runtime_error("Pipelined mode is not supported in cross-sectional mode");
+  }
+  if(enabled && !threadSafeResource(resource_))
+  {
+    throw std::runtime_error("Pipelined mode needs the default memory resource or a "
+                             "synchronized_pool_resource");
+  }
+  pipelined_ = enabled;
+  decodeBlockBars_ = decodeBlockBars;
+}
+
+void BacktestEngine::configureLedger(std::size_t memoryLimitBytes, std::string spillPath)
+{
+  ledger_ = TradeLedger(memoryLimitBytes, std::move(spillPath), resource_);
+}
+
+void BacktestEngine::setWarmup(std::size_t bars)
+{
+  warmupBars_ = bars;
+}
+
+void BacktestEngine::setFlattenPoints(std::vector<std::size_t> barIndices)
+{
+  std::sort(barIndices.begin(), barIndices.end());
+  flattenPoints_ = std::move(barIndices);
+  nextFlatten_ = 0;
+}
+
+void BacktestEngine::rebalance(const double *targetWeights, std::size_t n)
+{
+  if(!universe_)
+  {
+    throw std::logic_error("BacktestEngine::rebalance requires cross-sectional mode");
+  }
+  if(n != universe_->size())
+  {
+    throw std::invalid_argument("BacktestEngine::rebalance: expected one weight per universe symbol");
+  }
+
+  const UniverseView &view = universe_->view();
+  rebalancer_.computeTrades(targetWeights,
+                            view.close,
+                            view.valid,
+                            portfolio_.positions().data(),
+                            std::min(view.size, portfolio_.positions().size()),
+                            portfolio_.getEquity(),
+                            pendingOrders_);
+}
+
+void BacktestEngine::setRebalanceSettings(const RebalanceSettings &settings)
+{
+  rebalancer_ = Rebalancer(settings);
+}
+
 Report BacktestEngine::run()
 {
-  std::size_t index = 0;
+  TraceScope trace("engine run");
+
+  if(xsStrategy_)
+  {
+    return runCrossSectional();
+  }
+
+  std::size_t index = barsProcessed_;
+  const std::size_t firstIndex = index;
+
+  const AllocStats allocsBefore = AllocTracker::threadStats();
+  PhaseTracker phase(perfMode_, perfReport_);
 
   strategy_->onStart(*this);
 
+  if(resumed_)
+  {
+    resumeFeed();
+
+    std::istringstream stateIn(strategyState_);
+    CheckpointReader reader(stateIn);
+    strategy_->loadState(reader);
+
+    resumed_ = false;
+    strategyState_.clear();
+  }
+
+  std::unique_ptr<AsyncRecorder> recorder;
+  if(pipelined_)
+  {
+    // Wrapped once: a feed that already prefetches (from an earlier run,
+    // or "prefetch_bars") keeps its one decode thread.
+    if(dynamic_cast<PrefetchingFeed *>(feed_.get()) == nullptr)
+    {
+      feed_ = std::make_unique<PrefetchingFeed>(std::move(feed_), decodeBlockBars_);
+    }
+    recorder = std::make_unique<AsyncRecorder>(metrics_);
+  }
+
+  // Steady state starts once both the engine's and the strategy's warmup
+  // are over; from there on strict allocation tracking traps the loop.
+  const std::size_t strategyWarmup = strategy_->warmupBars();
+  const std::size_t steadyFrom = strategyWarmup == Strategy_I::unboundedWarmup
+                                   ? std::numeric_limits<std::size_t>::max()
+                                   : std::max(warmupBars_, strategyWarmup);
+  std::optional<AllocTrapScope> trap;
+
   while(feed_->hasNext())
   {
+    if(AllocTracker::enabled && !trap && index >= steadyFrom)
+    {
+      trap.emplace();
+    }
+
+    phase.enter(EnginePhase::Feed);
     const Candle &bar = feed_->next();
 
     // Strategy decides what to do; calls engine.placeOrder(...)
+    phase.enter(EnginePhase::Strategy);
     strategy_->onBar(index, bar, *this);
 
+    if(index < warmupBars_)
+    {
+      // Warmup: the strategy builds its state but nothing trades.
+      pendingOrders_.clear();
+      lastTimestamp_ = bar.timestamp;
+      ++index;
+      continue;
+    }
+
     // Execute pending orders
+    phase.enter(EnginePhase::Execution);
     for(const auto &o : pendingOrders_)
     {
       if(auto fill = exec_->execute(o, bar))
       {
-        portfolio_.applyFill(*fill);
+        recordFill(*fill);
       }
     }
     pendingOrders_.clear();
 
-    // Mark-to-market and record metrics
+    while(nextFlatten_ < flattenPoints_.size() && flattenPoints_[nextFlatten_] < index)
+    {
+      ++nextFlatten_;
+    }
+    if(nextFlatten_ < flattenPoints_.size() && flattenPoints_[nextFlatten_] == index)
+    {
+      flatten(bar);
+    }
+
+    // Mark-to-market; record metrics once per timestamp so multi-symbol
+    // feeds produce one equity point per time slice.
+    phase.enter(EnginePhase::MarkToMarket);
     portfolio_.markToMarket(bar);
-    metrics_.recordStep(portfolio_, bar.timestamp);
+    if(feed_->endOfSlice())
+    {
+      phase.enter(EnginePhase::Metrics);
+      if(recorder)
+      {
+        recorder->record(makeSnapshot(portfolio_, bar.timestamp));
+      }
+      else
+      {
+        metrics_.recordStep(portfolio_, bar.timestamp);
+      }
+    }
 
+    lastTimestamp_ = bar.timestamp;
     ++index;
   }
 
+  barsProcessed_ = index;
+  trap.reset();
+  phase.enter(EnginePhase::Teardown);
+
+  if(recorder)
+  {
+    recorder->finish();
+  }
+
   strategy_->onEnd(*this);
 
-  return metrics_.computeReport();
+  Report report = metrics_.computeReport();
+  allocStats_ = AllocTracker::threadStats();
+  allocStats_ -= allocsBefore;
+  phase.finish(index - firstIndex);
+  return report;
+}
+
+Report BacktestEngine::runCrossSectional()
+{
+  std::size_t index = 0;
+
+  const AllocStats allocsBefore = AllocTracker::threadStats();
+  PhaseTracker phase(perfMode_, perfReport_);
+
+  xsStrategy_->onStart(*this);
+
+  // Universe buffers are sized up front, so every slice is steady state.
+  std::optional<AllocTrapScope> trap;
+
+  while(universe_->hasNext())
+  {
+    if(AllocTracker::enabled && !trap && index >= warmupBars_)
+    {
+      trap.emplace();
+    }
+
+    phase.enter(EnginePhase::Feed);
+    const UniverseView &view = universe_->nextSlice();
+
+    phase.enter(EnginePhase::Strategy);
+    xsStrategy_->onSlice(index, view, *this);
+
+    // The slice's orders go to the execution engine as one batch, each
+    // against its symbol's bar; orders for symbols that did not trade at
+    // this timestamp get a null bar and are dropped.
+    phase.enter(EnginePhase::Execution);
+    if(!pendingOrders_.empty())
+    {
+      batchBars_.clear();
+      for(const auto &o : pendingOrders_)
+      {
+        batchBars_.push_back(universe_->bar(universe_->idOf(o.symbol)));
+      }
+
+      batchFills_.clear();
+      exec_->executeBatch(pendingOrders_, batchBars_, batchFills_);
+      for(const auto &fill : batchFills_)
+      {
+        recordFill(fill);
+      }
+      pendingOrders_.clear();
+    }
+
+    phase.enter(EnginePhase::MarkToMarket);
+    portfolio_.markToMarket(view.close, view.valid, view.size);
+    phase.enter(EnginePhase::Metrics);
+    metrics_.recordStep(portfolio_, *view.timestamp);
+
+    ++index;
+  }
+
+  barsProcessed_ = index;
+  trap.reset();
+  phase.enter(EnginePhase::Teardown);
+
+  xsStrategy_->onEnd(*this);
+
+  Report report = metrics_.computeReport();
+  allocStats_ = AllocTracker::threadStats();
+  allocStats_ -= allocsBefore;
+  phase.finish(index);
+  return report;
+}
+
+void BacktestEngine::recordFill(const Fill &fill)
+{
+  const double realized = portfolio_.applyFill(fill);
+
+  AllocPhaseScope phase(EnginePhase::Ledger);
+  ledger_.record(fill, realized);
+}
+
+void BacktestEngine::flatten(const Candle &bar)
+{
+  const Position *pos = portfolio_.getPosition(bar.symbol);
+  if(pos == nullptr || pos->quantity == 0)
+  {
+    return;
+  }
+
+  Order close;
+  close.symbol = bar.symbol;
+  close.side = pos->quantity > 0 ? OrderSide::Sell : OrderSide::Cover;
+  close.quantity = std::abs(pos->quantity);
+  if(auto fill = exec_->execute(close, bar))
+  {
+    recordFill(*fill);
+  }
+}
+
+void BacktestEngine::resumeFeed()
+{
+  if(barsProcessed_ == 0)
+  {
+    return;
+  }
+
+  // Replay position: skip everything but the last processed bar, then
+  // check that bar against the checkpoint so a rewritten history is caught
+  // instead of silently producing a mismatched result.
+  feed_->skip(barsProcessed_ - 1);
+  if(!feed_->hasNext())
+  {
+    throw std::runtime_error("Checkpoint covers more bars than the feed provides");
+  }
+
+  const Candle &last = feed_->next();
+  if(last.timestamp != lastTimestamp_)
+  {
+    throw std::runtime_error("Checkpoint does not match feed history: expected bar "
+                             + lastTimestamp_ + ", found " + last.timestamp);
+  }
+}
+
+void BacktestEngine::saveCheckpoint(std::ostream &out) const
+{
+  TraceScope trace("save checkpoint");
+  if(xsStrategy_)
+  {
+    throw std::runtime_error("Checkpointing is not supported in cross-sectional mode");
+  }
+
+  CheckpointWriter writer(out);
+  writer.writeU64(checkpointMagic);
+  writer.writeU64(checkpointVersion);
+  writer.writeU64(fixedPointMoney ? 1 : 0);
+  writer.writeU64(checkpointIdentity_);
+
+  writer.writeU64(barsProcessed_);
+  writer.writeString(lastTimestamp_);
+
+  portfolio_.saveState(writer);
+  metrics_.saveState(writer);
+
+  writer.writeU64(pendingOrders_.size());
+  for(const auto &o : pendingOrders_)
+  {
+    writer.writeString(o.symbol);
+    writer.writeI64(o.quantity);
+    writer.writeU64(static_cast<std::uint64_t>(o.side));
+    writer.writeU64(static_cast<std::uint64_t>(o.type));
+    writer.writeDouble(o.limitPrice);
+    writer.writeDouble(o.stopPrice);
+  }
+
+  std::ostringstream stateOut;
+  CheckpointWriter stateWriter(stateOut);
+  strategy_->saveState(stateWriter);
+  writer.writeString(stateOut.str());
+}
+
+void BacktestEngine::loadCheckpoint(std::istream &in)
+{
+  if(xsStrategy_)
+  {
+    throw std::runtime_error("Checkpointing is not supported in cross-sectional mode");
+  }
+
+  CheckpointReader reader(in);
+  if(reader.readU64() != checkpointMagic)
+  {
+    throw std::runtime_error("Not a backtest checkpoint");
+  }
+  if(reader.readU64() != checkpointVersion)
+  {
+    throw std::runtime_error("Unsupported checkpoint version");
+  }
+  if(reader.readU64() != (fixedPointMoney ? 1u : 0u))
+  {
+    throw std::runtime_error("Checkpoint was written with the other money representation "
+                             "(BACKTEST_FIXED_POINT_MONEY)");
+  }
+  if(reader.readU64() != checkpointIdentity_)
+  {
+    throw std::runtime_error("Checkpoint was written by a run with another strategy, "
+                             "symbols or engine settings");
+  }
+
+  barsProcessed_ = static_cast<std::size_t>(reader.readU64());
+  lastTimestamp_ = reader.readString();
+
+  portfolio_.loadState(reader);
+  metrics_.loadState(reader);
+
+  pendingOrders_.clear();
+  std::uint64_t orderCount = reader.readU64();
+  for(std::uint64_t i = 0; i < orderCount; ++i)
+  {
+    Order o;
+    o.symbol = reader.readString();
+    o.quantity = static_cast<int>(reader.readI64());
+    o.side = static_cast<OrderSide>(reader.readU64());
+    o.type = static_cast<OrderType>(reader.readU64());
+    o.limitPrice = reader.readDouble();
+    o.stopPrice = reader.readDouble();
+    pendingOrders_.push_back(o);
+  }
+
+  strategyState_ = reader.readString();
+  resumed_ = true;
 }
@@ -0,0 +1,481 @@
+#include "BacktestServer.hpp"
+#include "BacktestEngine.hpp"
+#include "Log.hpp"
+#include "ResultCache.hpp"
+#include "RunArena.hpp"
+#include "RunBuilder.hpp"
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using nlohmann::json;
+
+namespace
+{
+
+// A request line longer than this is rejected and the connection closed.
+constexpr std::size_t maxRequestBytes = 16u << 20;
+
+// A client that stops reading for this long is dropped, so a worker is
+// never stuck writing to it and serve() can always join its workers.
+constexpr int sendTimeoutSeconds = 30;
+
+std::runtime_error systemError(const std::string &what)
+{
+  return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+// Cache key of a symbol's bars: the data block without the settings that
+// do not change which bars are loaded.
+std::string datasetKey(const json &dataCfg, const std::string &symbol)
+{
+  json selection = dataCfg;
+  for(const char *key : { "prefetch_bars", "precision", "concurrency", "requests_per_minute" })
+  {
+    selection.erase(key);
+  }
+  return selection.dump() + "/" + symbol;
+}
+
+// Run config settings backtest_engine honours and a server job cannot:
+// they are refused rather than silently dropped.
+void rejectUnsupported(const json &job)
+{
+  for(const char *key : { "checkpoint", "result_cache", "trade_ledger", "trace", "log_level" })
+  {
+    if(job.contains(key))
+    {
+      throw std::runtime_error(std::string{ "Not supported by the server: " } + key);
+    }
+  }
+
+  const json engineCfg = job.value("engine", json::object());
+  if(engineCfg.value("perf_counters", std::string{ "off" }) != "off")
+  {
+    throw std::runtime_error("Not supported by the server: engine.perf_counters");
+  }
+  if(engineCfg.value("alloc_tracking", std::string{ "off" }) != "off")
+  {
+    throw std::runtime_error("Not supported by the server: engine.alloc_tracking");
+  }
+  const json dataCfg = job.value("data", json::object());
+  if(dataCfg.value("precision", std::string{ "float64" }) != "float64")
+  {
+    throw std::runtime_error("Not supported by the server: data.precision");
+  }
+}
+
+} // namespace
+
+struct BacktestServer::Connection
+{
+  explicit Connection(int socketFd)
+    : fd(socketFd) {}
+
+  ~Connection() { ::close(fd); }
+
+  // Whole lines only, so concurrent workers never interleave responses.
+  // A client that went away, or stopped reading until the send timed out,
+  // is dropped: the rest of its results are discarded and its reader sees
+  // end of file.
+  void send(const std::string &line)
+  {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    std::size_t sent = 0;
+    while(sent < line.size() && !dropped)
+    {
+      ssize_t n = ::send(fd, line.data() + sent, line.size() - sent, MSG_NOSIGNAL);
+      if(n < 0 && errno == EINTR)
+      {
+        continue;
+      }
+      if(n <= 0)
+      {
+        dropped = true;
+        ::shutdown(fd, SHUT_RDWR);
+        return;
+      }
+      sent += static_cast<std::size_t>(n);
+    }
+  }
+
+  int fd;
+  std::mutex writeMutex;
+  bool dropped{};
+};
+
+BacktestServer::BacktestServer(std::string socketPath, std::size_t threads, Loader loader)
+  : socketPath_(std::move(socketPath)),
+    threadCount_(threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency())),
+    loader_(std::move(loader))
+{
+  if(!loader_)
+  {
+    // Every bar of the selection, whatever the job's strategy reads, so
+    // the dataset serves any later job.
+    loader_ = [](const json &dataCfg, const std::vector<std::string> &symbols)
+    { return fetchSeries(dataCfg, symbols); };
+  }
+
+  if(::pipe2(wakeFds_, O_CLOEXEC | O_NONBLOCK) != 0)
+  {
+    throw systemError("pipe2");
+  }
+}
+
+BacktestServer::~BacktestServer()
+{
+  ::close(wakeFds_[0]);
+  ::close(wakeFds_[1]);
+}
+
+void BacktestServer::addDataset(const json &dataCfg, const std::string &symbol,
+                                std::vector<Candle> candles)
+{
+  auto data = std::make_shared<const std::vector<Candle>>(std::move(candles));
+  std::lock_guard<std::mutex> lock(datasetsMutex_);
+  datasets_[datasetKey(dataCfg, symbol)] = std::move(data);
+}
+
+std::vector<BacktestServer::Dataset>
+BacktestServer::datasets(const json &dataCfg, const std::vector<std::string> &symbols)
+{
+  std::vector<Dataset> data(symbols.size());
+  std::vector<std::string> missing;
+  {
+    std::lock_guard<std::mutex> lock(datasetsMutex_);
+    for(std::size_t i = 0; i < symbols.size(); ++i)
+    {
+      auto it = datasets_.find(datasetKey(dataCfg, symbols[i]));
+      if(it != datasets_.end())
+      {
+        data[i] = it->second;
+      }
+      else
+      {
+        missing.push_back(symbols[i]);
+      }
+    }
+  }
+  if(missing.empty())
+  {
+    return data;
+  }
+
+  // Loaded outside the lock so other jobs keep running; two first jobs
+  // for the same symbol may both load it, and the first one in wins.
+  TraceScope trace("load dataset");
+  std::vector<std::vector<Candle>> loaded = loader_(dataCfg, missing);
+  for(std::size_t i = 0; i < missing.size(); ++i)
+  {
+    if(loaded.at(i).empty())
+    {
+      throw std::runtime_error("No candles for symbol " + missing[i]);
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(datasetsMutex_);
+  for(std::size_t i = 0, m = 0; i < symbols.size(); ++i)
+  {
+    if(!data[i])
+    {
+      auto candles = std::make_shared<const std::vector<Candle>>(std::move(loaded[m++]));
+      data[i] = datasets_.emplace(datasetKey(dataCfg, symbols[i]), std::move(candles))
+                  .first->second;
+    }
+  }
+  return data;
+}
+
+json BacktestServer::runJob(const json &job)
+{
+  try
+  {
+    return execute(job, std::pmr::get_default_resource());
+  }
+  catch(const std::exception &ex)
+  {
+    json response = { { "status", "error" }, { "error", ex.what() } };
+    if(job.is_object() && job.contains("id"))
+    {
+      response["id"] = job.at("id");
+    }
+    return response;
+  }
+}
+
+json BacktestServer::execute(const json &job, std::pmr::memory_resource *resource)
+{
+  static std::atomic<std::int64_t> jobCount{ 0 };
+  LogContext context("job", jobCount++);
+  TraceScope trace("server job");
+  const auto started = std::chrono::steady_clock::now();
+
+  rejectUnsupported(job);
+  const std::vector<std::string> symbols = configSymbols(job);
+  const json engineCfg = job.value("engine", json::object());
+  const std::string mode = engineCfg.value("mode", std::string{ "per_bar" });
+  if(mode != "per_bar" && mode != "cross_sectional")
+  {
+    throw std::runtime_error("Unsupported engine mode: " + mode);
+  }
+
+  // A shared-memory dataset is resident already; other providers' bars
+  // are kept here across jobs.
+  const json &dataCfg = job.at("data");
+  RunData data;
+  if(dataCfg.at("provider").get<std::string>() == "shared_memory")
+  {
+    data = loadRunData(dataCfg, symbols, mode, runBarFields(mode, symbols, job.at("strategy")));
+  }
+  else
+  {
+    data.resident = datasets(dataCfg, symbols);
+  }
+
+  // A pipelined run records metrics on a thread of its own, which must not
+  // share the worker's unsynchronized arena with the simulation thread.
+  if(engineCfg.value("pipelined", false))
+  {
+    resource = std::pmr::get_default_resource();
+  }
+  std::unique_ptr<BacktestEngine> engine = buildEngine(job, data, resource);
+  Report report = engine->run();
+
+  json response = {
+    { "status", "ok" },
+    { "report", reportToJson(report) },
+    { "final_equity", engine->portfolio().getEquity() },
+    { "trades", engine->ledger().size() },
+    { "bars", engine->barsProcessed() },
+    { "elapsed_us", std::chrono::duration_cast<std::chrono::microseconds>(
+                      std::chrono::steady_clock::now() - started)
+                      .count() }
+  };
+  if(job.contains("id"))
+  {
+    response["id"] = job.at("id");
+  }
+  return response;
+}
+
+void BacktestServer::stop()
+{
+  const char byte = 1;
+  ssize_t n = ::write(wakeFds_[1], &byte, 1);
+  (void)n;
+}
+
+void BacktestServer::serve()
+{
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if(socketPath_.size() >= sizeof(address.sun_path))
+  {
+    throw std::runtime_error("Socket path too long: " + socketPath_);
+  }
+  std::memcpy(address.sun_path, socketPath_.c_str(), socketPath_.size() + 1);
+
+  // A socket left behind by a previous server is replaced; anything else
+  // at that path is not ours to delete.
+  struct stat existing{};
+  if(::lstat(socketPath_.c_str(), &existing) == 0)
+  {
+    if(!S_ISSOCK(existing.st_mode))
+    {
+      throw std::runtime_error("Not a socket: " + socketPath_);
+    }
+    ::unlink(socketPath_.c_str());
+  }
+
+  const int listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if(listenFd < 0)
+  {
+    throw systemError("socket");
+  }
+  if(::bind(listenFd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0
+     || ::listen(listenFd, 64) != 0)
+  {
+    const auto error = systemError("bind " + socketPath_);
+    ::close(listenFd);
+    throw error;
+  }
+
+  stopping_ = false;
+  for(std::size_t i = 0; i < threadCount_; ++i)
+  {
+    workers_.emplace_back([this] { work(); });
+  }
+
+  pollfd fds[2] = { { listenFd, POLLIN, 0 }, { wakeFds_[0], POLLIN, 0 } };
+  for(;;)
+  {
+    if(::poll(fds, 2, -1) < 0)
+    {
+      if(errno == EINTR)
+      {
+        continue;
+      }
+      break;
+    }
+    if(fds[1].revents != 0)
+    {
+      break;
+    }
+    if((fds[0].revents & POLLIN) == 0)
+    {
+      continue;
+    }
+
+    const int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+    if(fd < 0)
+    {
+      continue;
+    }
+
+    const timeval sendTimeout{ sendTimeoutSeconds, 0 };
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &sendTimeout, sizeof(sendTimeout));
+
+    auto connection = std::make_shared<Connection>(fd);
+    std::lock_guard<std::mutex> lock(connectionsMutex_);
+    connections_.erase(std::remove_if(connections_.begin(), connections_.end(),
+                                      [](const std::weak_ptr<Connection> &c) { return c.expired(); }),
+                       connections_.end());
+    connections_.push_back(connection);
+    ++activeReaders_;
+    std::thread([this, connection]
+                {
+                  readConnection(connection);
+                  std::lock_guard<std::mutex> done(connectionsMutex_);
+                  --activeReaders_;
+                  readersDone_.notify_all();
+                })
+      .detach();
+  }
+
+  ::close(listenFd);
+  ::unlink(socketPath_.c_str());
+
+  char drained[64];
+  while(::read(wakeFds_[0], drained, sizeof(drained)) > 0)
+  {
+  }
+
+  // Stop reading new jobs, finish the queued ones, then shut down.
+  {
+    std::unique_lock<std::mutex> lock(connectionsMutex_);
+    for(const auto &weak : connections_)
+    {
+      if(auto connection = weak.lock())
+      {
+        ::shutdown(connection->fd, SHUT_RD);
+      }
+    }
+    readersDone_.wait(lock, [&] { return activeReaders_ == 0; });
+    connections_.clear();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    stopping_ = true;
+  }
+  queueReady_.notify_all();
+  for(auto &worker : workers_)
+  {
+    worker.join();
+  }
+  workers_.clear();
+}
+
+void BacktestServer::readConnection(std::shared_ptr<Connection> connection)
+{
+  std::string pending;
+  char buffer[1 << 16];
+  for(;;)
+  {
+    const ssize_t n = ::recv(connection->fd, buffer, sizeof(buffer), 0);
+    if(n < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if(n <= 0)
+    {
+      return;
+    }
+    pending.append(buffer, static_cast<std::size_t>(n));
+
+    std::size_t begin = 0;
+    for(std::size_t end; (end = pending.find('\n', begin)) != std::string::npos; begin = end + 1)
+    {
+      if(end > begin)
+      {
+        {
+          std::lock_guard<std::mutex> lock(queueMutex_);
+          queue_.push_back({ connection, pending.substr(begin, end - begin) });
+        }
+        queueReady_.notify_one();
+      }
+    }
+    pending.erase(0, begin);
+
+    if(pending.size() > maxRequestBytes)
+    {
+      connection->send(json{ { "status", "error" }, { "error", "Request too large" } }.dump() + "\n");
+      return;
+    }
+  }
+}
+
+void BacktestServer::work()
+{
+  // Like a sweep worker: every job's engine state comes from one arena
+  // that is reset between jobs.
+  RunArena arena;
+  for(;;)
+  {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(queueMutex_);
+      queueReady_.wait(lock, [&] { return stopping_ || !queue_.empty(); });
+      if(queue_.empty())
+      {
+        return;
+      }
+      job = std::move(queue_.front());
+      queue_.pop_front();
+    }
+
+    json request;
+    json response;
+    try
+    {
+      request = json::parse(job.request);
+      response = execute(request, arena.resource());
+    }
+    catch(const std::exception &ex)
+    {
+      response = { { "status", "error" }, { "error", ex.what() } };
+      if(request.is_object() && request.contains("id"))
+      {
+        response["id"] = request.at("id");
+      }
+    }
+    arena.reset();
+
+    job.connection->send(response.dump() + "\n");
+  }
+}
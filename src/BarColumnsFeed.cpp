@@ -0,0 +1,54 @@
+#include "feed/BarColumnsFeed.hpp"
+#include "Timestamp.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+template <typename Scalar>
+BarColumnsFeed<Scalar>::BarColumnsFeed(const BasicBarColumns<Scalar> &bars, BarFields fields)
+  : bars_(bars), fields_(fields)
+{
+  bar_.symbol = bars_.symbol;
+}
+
+template <typename Scalar>
+const Candle &BarColumnsFeed<Scalar>::next()
+{
+  if(!hasNext())
+  {
+    throw std::out_of_range("BarColumnsFeed::next called with no more data");
+  }
+
+  const std::size_t row = row_++;
+  formatTimestamp(bars_.time[row], bar_.timestamp);
+  if(fields_ & BarField::Open)
+  {
+    bar_.open = static_cast<double>(bars_.open[row]);
+  }
+  if(fields_ & BarField::High)
+  {
+    bar_.high = static_cast<double>(bars_.high[row]);
+  }
+  if(fields_ & BarField::Low)
+  {
+    bar_.low = static_cast<double>(bars_.low[row]);
+  }
+  if(fields_ & BarField::Close)
+  {
+    bar_.close = static_cast<double>(bars_.close[row]);
+  }
+  if(fields_ & BarField::Volume)
+  {
+    bar_.volume = static_cast<double>(bars_.volume[row]);
+  }
+  return bar_;
+}
+
+template <typename Scalar>
+void BarColumnsFeed<Scalar>::skip(std::size_t count)
+{
+  row_ = std::min(bars_.size(), row_ + count);
+}
+
+template class BarColumnsFeed<float>;
+template class BarColumnsFeed<double>;
@@ -0,0 +1,241 @@
+#include "CandleStore.hpp"
+#include "FileUtil.hpp"
+#include "Timestamp.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+
+struct StoredBar
+{
+  std::int64_t time;
+  double open;
+  double high;
+  double low;
+  double close;
+  double volume;
+};
+
+constexpr char storeMagic[8] = { 'B', 'T', 'B', 'A', 'R', 'S', '1', '\0' };
+constexpr std::uint64_t headerBytes = sizeof(storeMagic) + sizeof(std::uint64_t);
+constexpr std::uint64_t recordBytes = sizeof(StoredBar);
+
+static_assert(recordBytes == 48, "records are written as raw structs");
+
+// Read access to one symbol's file. A torn trailing record (from an
+// interrupted write) is ignored.
+class BarFile
+{
+public:
+  explicit BarFile(const std::string &path)
+    : in_(path, std::ios::binary)
+  {
+    if(!in_)
+    {
+      return;
+    }
+
+    char magic[sizeof(storeMagic)] = {};
+    std::uint64_t recordSize = 0;
+    in_.read(magic, sizeof(magic));
+    in_.read(reinterpret_cast<char *>(&recordSize), sizeof(recordSize));
+    if(!in_ || std::memcmp(magic, storeMagic, sizeof(magic)) != 0 || recordSize != recordBytes)
+    {
+      throw std::runtime_error("Not a candle store file: " + path);
+    }
+
+    const std::uint64_t bytes = std::filesystem::file_size(path);
+    count_ = static_cast<std::size_t>((bytes - headerBytes) / recordBytes);
+  }
+
+  std::size_t size() const { return count_; }
+
+  std::vector<StoredBar> read(std::size_t first, std::size_t count)
+  {
+    std::vector<StoredBar> bars(count);
+    if(count == 0)
+    {
+      return bars;
+    }
+    in_.seekg(static_cast<std::streamoff>(headerBytes + first * recordBytes));
+    in_.read(reinterpret_cast<char *>(bars.data()),
+             static_cast<std::streamsize>(count * recordBytes));
+    if(!in_)
+    {
+      throw std::runtime_error("Candle store file is unreadable");
+    }
+    return bars;
+  }
+
+  std::int64_t timeAt(std::size_t i) { return read(i, 1).front().time; }
+
+  // First record with time >= t, by binary search over the file.
+  std::size_t lowerBound(std::int64_t t)
+  {
+    std::size_t lo = 0;
+    std::size_t hi = count_;
+    while(lo < hi)
+    {
+      std::size_t mid = lo + (hi - lo) / 2;
+      if(timeAt(mid) < t)
+      {
+        lo = mid + 1;
+      }
+      else
+      {
+        hi = mid;
+      }
+    }
+    return lo;
+  }
+
+private:
+  std::ifstream in_;
+  std::size_t count_{};
+};
+
+void writeHeader(std::ostream &out)
+{
+  out.write(storeMagic, sizeof(storeMagic));
+  out.write(reinterpret_cast<const char *>(&recordBytes), sizeof(recordBytes));
+}
+
+void writeBars(std::ostream &out, const StoredBar *bars, std::size_t count)
+{
+  out.write(reinterpret_cast<const char *>(bars),
+            static_cast<std::streamsize>(count * recordBytes));
+}
+
+} // namespace
+
+CandleStore::CandleStore(std::string directory)
+  : directory_(std::move(directory))
+{
+  std::filesystem::create_directories(directory_);
+}
+
+std::string CandleStore::pathFor(const std::string &symbol) const
+{
+  if(symbol.empty() || symbol.find_first_of("/\\") != std::string::npos || symbol[0] == '.')
+  {
+    throw std::runtime_error("Invalid symbol for the candle store: '" + symbol + "'");
+  }
+  return (std::filesystem::path(directory_) / (symbol + ".bars")).string();
+}
+
+std::optional<std::int64_t> CandleStore::lastTime(const std::string &symbol) const
+{
+  BarFile file(pathFor(symbol));
+  if(file.size() == 0)
+  {
+    return std::nullopt;
+  }
+  return file.timeAt(file.size() - 1);
+}
+
+std::size_t CandleStore::size(const std::string &symbol) const
+{
+  return BarFile(pathFor(symbol)).size();
+}
+
+std::vector<Candle> CandleStore::load(const std::string &symbol, int lookbackBars,
+                                      const TimeRange &range) const
+{
+  BarFile file(pathFor(symbol));
+  std::size_t first = range.start > std::numeric_limits<std::int64_t>::min()
+                        ? file.lowerBound(range.start)
+                        : 0;
+  const std::size_t last = range.end < std::numeric_limits<std::int64_t>::max()
+                             ? file.lowerBound(range.end + 1)
+                             : file.size();
+  if(lookbackBars > 0 && static_cast<std::size_t>(lookbackBars) < last - first)
+  {
+    first = last - static_cast<std::size_t>(lookbackBars);
+  }
+
+  std::vector<Candle> candles;
+  candles.reserve(last - first);
+  for(const StoredBar &b : file.read(first, last - first))
+  {
+    candles.push_back({ formatTimestamp(b.time), symbol, b.open, b.high, b.low, b.close,
+                        b.volume });
+  }
+  return candles;
+}
+
+std::size_t CandleStore::merge(const std::string &symbol, const std::vector<Candle> &bars)
+{
+  if(bars.empty())
+  {
+    return 0;
+  }
+
+  std::vector<StoredBar> incoming;
+  incoming.reserve(bars.size());
+  for(const Candle &c : bars)
+  {
+    incoming.push_back(
+      { parseTimestamp(c.timestamp), c.open, c.high, c.low, c.close, c.volume });
+    if(incoming.size() > 1 && incoming.back().time <= incoming[incoming.size() - 2].time)
+    {
+      throw std::runtime_error("Bars merged into the store for " + symbol
+                               + " are not sorted by time");
+    }
+  }
+
+  const std::string path = pathFor(symbol);
+  std::size_t stored = 0;
+  std::size_t first = 0;
+  std::size_t last = 0;
+  std::vector<StoredBar> kept;
+  {
+    BarFile file(path);
+    stored = file.size();
+    first = file.lowerBound(incoming.front().time);
+    last = file.lowerBound(incoming.back().time + 1);
+    if(last < stored)
+    {
+      // Stored bars survive on both sides of the new range.
+      kept = file.read(0, stored);
+    }
+  }
+  const std::size_t merged = stored - (last - first) + incoming.size();
+
+  if(last == stored && stored > 0)
+  {
+    // Refresh: drop the overlapping tail and append in place.
+    std::filesystem::resize_file(path, headerBytes + first * recordBytes);
+    std::ofstream out(path, std::ios::binary | std::ios::app);
+    writeBars(out, incoming.data(), incoming.size());
+    if(!out)
+    {
+      throw std::runtime_error("Failed to append to candle store file: " + path);
+    }
+  }
+  else
+  {
+    const std::string tmp = uniqueTempPath(path);
+    {
+      std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+      writeHeader(out);
+      writeBars(out, kept.data(), first);
+      writeBars(out, incoming.data(), incoming.size());
+      writeBars(out, kept.data() + last, kept.size() - std::min(last, kept.size()));
+      out.close();
+      if(!out)
+      {
+        std::filesystem::remove(tmp);
+        throw std::runtime_error("Failed to write candle store file: " + tmp);
+      }
+    }
+    std::filesystem::rename(tmp, path);
+  }
+
+  return merged > stored ? merged - stored : 0;
+}
@@ -0,0 +1,75 @@
+#include "Checkpoint.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+void CheckpointWriter::writeU64(std::uint64_t v)
+{
+  out_.write(reinterpret_cast<const char *>(&v), sizeof(v));
+  if(!out_)
+  {
+    throw std::runtime_error("Failed to write checkpoint");
+  }
+}
+
+void CheckpointWriter::writeI64(std::int64_t v)
+{
+  writeU64(static_cast<std::uint64_t>(v));
+}
+
+void CheckpointWriter::writeDouble(double v)
+{
+  std::uint64_t bits = 0;
+  std::memcpy(&bits, &v, sizeof(bits));
+  writeU64(bits);
+}
+
+void CheckpointWriter::writeString(const std::string &s)
+{
+  writeU64(s.size());
+  out_.write(s.data(), static_cast<std::streamsize>(s.size()));
+  if(!out_)
+  {
+    throw std::runtime_error("Failed to write checkpoint");
+  }
+}
+
+std::uint64_t CheckpointReader::readU64()
+{
+  std::uint64_t v = 0;
+  in_.read(reinterpret_cast<char *>(&v), sizeof(v));
+  if(!in_)
+  {
+    throw std::runtime_error("Checkpoint is truncated or unreadable");
+  }
+  return v;
+}
+
+std::int64_t CheckpointReader::readI64()
+{
+  return static_cast<std::int64_t>(readU64());
+}
+
+double CheckpointReader::readDouble()
+{
+  std::uint64_t bits = readU64();
+  double v = 0.0;
+  std::memcpy(&v, &bits, sizeof(v));
+  return v;
+}
+
+std::string CheckpointReader::readString()
+{
+  std::uint64_t size = readU64();
+  if(size > (std::uint64_t{ 1 } << 32))
+  {
+    throw std::runtime_error("Checkpoint string length is corrupt");
+  }
+  std::string s(static_cast<std::size_t>(size), '\0');
+  in_.read(s.data(), static_cast<std::streamsize>(size));
+  if(!in_)
+  {
+    throw std::runtime_error("Checkpoint is truncated or unreadable");
+  }
+  return s;
+}
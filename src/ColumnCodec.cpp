@@ -0,0 +1,316 @@
+#include "ColumnCodec.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+
+enum class Mode : std::uint8_t
+{
+  Raw,
+  FrameOfReference, // value - base
+  Delta             // zigzag(value - previous), base = first value
+};
+
+enum class ValueType : std::uint8_t
+{
+  Int64,
+  Double
+};
+
+struct BlockHeader
+{
+  Mode mode;
+  std::uint8_t width; // bits per packed value
+  std::uint8_t scale; // doubles: value = integer / 10^scale
+  ValueType type;
+  std::uint32_t reserved;
+  std::uint64_t base;
+};
+
+static_assert(sizeof(BlockHeader) == 16, "block headers are written as raw structs");
+
+// Widths above this would need a second load per value.
+constexpr unsigned maxPackedWidth = 56;
+
+// Packed payloads end with this many zero bytes so every value can be
+// read with one unaligned 8-byte load.
+constexpr std::size_t loadPadding = 8;
+
+constexpr double powersOfTen[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+constexpr std::uint8_t maxScale = 9;
+
+unsigned bitWidth(std::uint64_t v)
+{
+  unsigned bits = 0;
+  while(v != 0)
+  {
+    ++bits;
+    v >>= 1;
+  }
+  return bits;
+}
+
+std::uint64_t zigzag(std::uint64_t delta)
+{
+  return (delta << 1) ^ (0 - (delta >> 63));
+}
+
+std::uint64_t unzigzag(std::uint64_t v)
+{
+  return (v >> 1) ^ (0 - (v & 1));
+}
+
+std::size_t packedBytes(std::size_t count, unsigned width)
+{
+  return (count * width + 7) / 8 + loadPadding;
+}
+
+std::size_t appendHeader(const BlockHeader &header, std::vector<std::uint8_t> &out)
+{
+  const std::size_t at = out.size();
+  out.resize(at + sizeof(header));
+  std::memcpy(out.data() + at, &header, sizeof(header));
+  return sizeof(header);
+}
+
+std::size_t appendRaw(const void *values, std::size_t count, ValueType type,
+                      std::vector<std::uint8_t> &out)
+{
+  std::size_t bytes = appendHeader({ Mode::Raw, 64, 0, type, 0, 0 }, out);
+  const std::size_t at = out.size();
+  out.resize(at + count * 8);
+  std::memcpy(out.data() + at, values, count * 8);
+  return bytes + count * 8;
+}
+
+// Wrapping (unsigned) arithmetic throughout: any int64 range round-trips.
+std::size_t appendPacked(const std::uint64_t *values, std::size_t count, std::uint8_t scale,
+                         ValueType type, std::vector<std::uint8_t> &out)
+{
+  std::uint64_t lo = 0;
+  std::uint64_t hi = 0;
+  std::uint64_t maxZigzag = 0;
+  for(std::size_t i = 0; i < count; ++i)
+  {
+    const auto v = static_cast<std::int64_t>(values[i]);
+    if(i == 0 || v < static_cast<std::int64_t>(lo))
+    {
+      lo = values[i];
+    }
+    if(i == 0 || v > static_cast<std::int64_t>(hi))
+    {
+      hi = values[i];
+    }
+    if(i > 0)
+    {
+      maxZigzag = std::max(maxZigzag, zigzag(values[i] - values[i - 1]));
+    }
+  }
+
+  // Ties go to frame-of-reference, which decodes without a running sum.
+  const unsigned forWidth = bitWidth(hi - lo);
+  const unsigned deltaWidth = bitWidth(maxZigzag);
+  const Mode mode = deltaWidth < forWidth ? Mode::Delta : Mode::FrameOfReference;
+  const unsigned width = std::min(forWidth, deltaWidth);
+  if(width > maxPackedWidth)
+  {
+    return 0;
+  }
+  const std::uint64_t base = count == 0 ? 0 : mode == Mode::Delta ? values[0] : lo;
+
+  std::size_t bytes = appendHeader(
+    { mode, static_cast<std::uint8_t>(width), scale, type, 0, base }, out);
+  const std::size_t at = out.size();
+  out.resize(at + packedBytes(count, width), 0);
+  std::uint8_t *data = out.data() + at;
+
+  std::uint64_t accumulator = 0;
+  unsigned filled = 0;
+  std::size_t pos = 0;
+  for(std::size_t i = 0; i < count; ++i)
+  {
+    const std::uint64_t v = mode == Mode::Delta
+                              ? (i == 0 ? 0 : zigzag(values[i] - values[i - 1]))
+                              : values[i] - lo;
+    accumulator |= v << filled;
+    filled += width;
+    while(filled >= 8)
+    {
+      data[pos++] = static_cast<std::uint8_t>(accumulator);
+      accumulator >>= 8;
+      filled -= 8;
+    }
+  }
+  if(filled > 0)
+  {
+    data[pos] = static_cast<std::uint8_t>(accumulator);
+  }
+  return bytes + packedBytes(count, width);
+}
+
+BlockHeader readHeader(const std::uint8_t *block, std::size_t bytes, std::size_t count,
+                       ValueType type)
+{
+  BlockHeader header{};
+  if(bytes < sizeof(header))
+  {
+    throw std::runtime_error("Column block is truncated");
+  }
+  std::memcpy(&header, block, sizeof(header));
+
+  std::size_t payload = 0;
+  switch(header.mode)
+  {
+  case Mode::Raw:
+    payload = count * 8;
+    break;
+  case Mode::FrameOfReference:
+  case Mode::Delta:
+    if(header.width > maxPackedWidth || header.scale > maxScale)
+    {
+      throw std::runtime_error("Column block header is corrupt");
+    }
+    payload = packedBytes(count, header.width);
+    break;
+  default:
+    throw std::runtime_error("Column block header is corrupt");
+  }
+  if(header.type != type)
+  {
+    throw std::runtime_error("Column block holds another value type");
+  }
+  if(bytes < sizeof(header) + payload)
+  {
+    throw std::runtime_error("Column block is truncated");
+  }
+  return header;
+}
+
+// One pass over the packed bits: unpack, undo delta/offset and convert,
+// with `store(i, integer)` writing the output. Each value is one
+// unaligned load, shift and mask, which the compiler unrolls and
+// vectorizes for the frame-of-reference mode; delta mode adds one
+// dependent add per value.
+template <typename Store>
+void unpack(const BlockHeader &header, const std::uint8_t *data, std::size_t count, Store store)
+{
+  const unsigned width = header.width;
+  const std::uint64_t mask = (std::uint64_t{ 1 } << width) - 1;
+  const std::uint64_t base = header.base;
+
+  auto at = [&](std::size_t i)
+  {
+    const std::size_t bit = i * width;
+    std::uint64_t word;
+    std::memcpy(&word, data + bit / 8, sizeof(word));
+    return (word >> (bit % 8)) & mask;
+  };
+
+  if(header.mode == Mode::FrameOfReference)
+  {
+    for(std::size_t i = 0; i < count; ++i)
+    {
+      store(i, base + at(i));
+    }
+  }
+  else
+  {
+    std::uint64_t value = base;
+    for(std::size_t i = 0; i < count; ++i)
+    {
+      value += unzigzag(at(i));
+      store(i, value);
+    }
+  }
+}
+
+} // namespace
+
+std::size_t encodeColumn(const std::int64_t *values, std::size_t count,
+                         ColumnEncoding encoding, std::vector<std::uint8_t> &out)
+{
+  if(encoding == ColumnEncoding::Packed)
+  {
+    // Same bits, unsigned view.
+    std::vector<std::uint64_t> bits(count);
+    std::memcpy(bits.data(), values, count * sizeof(std::uint64_t));
+    if(std::size_t bytes = appendPacked(bits.data(), count, 0, ValueType::Int64, out))
+    {
+      return bytes;
+    }
+  }
+  return appendRaw(values, count, ValueType::Int64, out);
+}
+
+std::size_t encodeColumn(const double *values, std::size_t count,
+                         ColumnEncoding encoding, std::vector<std::uint8_t> &out)
+{
+  if(encoding == ColumnEncoding::Packed)
+  {
+    // Smallest decimal scale at which every value is an exact integer
+    // number of ticks: decoding divides by the same power of ten, and a
+    // correctly rounded division returns the original double bit for bit.
+    std::vector<std::uint64_t> ticks(count);
+    for(std::uint8_t scale = 0; scale <= maxScale; ++scale)
+    {
+      const double p = powersOfTen[scale];
+      bool exact = true;
+      for(std::size_t i = 0; i < count && exact; ++i)
+      {
+        const double t = std::nearbyint(values[i] * p);
+        if(!(std::fabs(t) < 9.0e15))
+        {
+          exact = false;
+          break;
+        }
+        // Compared bit for bit, so -0.0 (which decodes as 0.0) is rejected.
+        const auto tick = static_cast<std::int64_t>(t);
+        const double back = static_cast<double>(tick) / p;
+        exact = std::memcmp(&back, &values[i], sizeof(back)) == 0;
+        ticks[i] = static_cast<std::uint64_t>(tick);
+      }
+      if(exact)
+      {
+        if(std::size_t bytes = appendPacked(ticks.data(), count, scale, ValueType::Double, out))
+        {
+          return bytes;
+        }
+        break;
+      }
+    }
+  }
+  return appendRaw(values, count, ValueType::Double, out);
+}
+
+void decodeColumn(const std::uint8_t *block, std::size_t bytes, std::size_t count,
+                  std::int64_t *out)
+{
+  const BlockHeader header = readHeader(block, bytes, count, ValueType::Int64);
+  const std::uint8_t *data = block + sizeof(header);
+  if(header.mode == Mode::Raw)
+  {
+    std::memcpy(out, data, count * sizeof(*out));
+    return;
+  }
+  unpack(header, data, count,
+         [out](std::size_t i, std::uint64_t v) { out[i] = static_cast<std::int64_t>(v); });
+}
+
+void decodeColumn(const std::uint8_t *block, std::size_t bytes, std::size_t count, double *out)
+{
+  const BlockHeader header = readHeader(block, bytes, count, ValueType::Double);
+  const std::uint8_t *data = block + sizeof(header);
+  if(header.mode == Mode::Raw)
+  {
+    std::memcpy(out, data, count * sizeof(*out));
+    return;
+  }
+  const double p = powersOfTen[header.scale];
+  unpack(header, data, count,
+         [out, p](std::size_t i, std::uint64_t v)
+         { out[i] = static_cast<double>(static_cast<std::int64_t>(v)) / p; });
+}
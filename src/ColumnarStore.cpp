@@ -0,0 +1,388 @@
+#include "ColumnarStore.hpp"
+#include "Timestamp.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+using nlohmann::json;
+
+namespace
+{
+
+constexpr char shardMagic[8] = { 'B', 'T', 'C', 'O', 'L', 'S', '3', '\0' };
+constexpr std::uint64_t trailerBytes = sizeof(std::uint64_t) + sizeof(shardMagic);
+constexpr const char *manifestName = "manifest.json";
+
+template <typename T>
+void readExact(std::ifstream &in, T *data, std::size_t count, const std::string &path)
+{
+  in.read(reinterpret_cast<char *>(data), static_cast<std::streamsize>(count * sizeof(T)));
+  if(!in)
+  {
+    throw std::runtime_error("Columnar shard is truncated: " + path);
+  }
+}
+
+} // namespace
+
+ColumnarShardWriter::ColumnarShardWriter(std::string path, std::size_t chunkRows,
+                                         ColumnEncoding encoding)
+  : path_(std::move(path)),
+    chunkRows_(std::max<std::size_t>(chunkRows, 1)),
+    encoding_(encoding),
+    out_(path_, std::ios::binary | std::ios::trunc)
+{
+  if(!out_)
+  {
+    throw std::runtime_error("Failed to create columnar shard: " + path_);
+  }
+  append(shardMagic, sizeof(shardMagic));
+}
+
+void ColumnarShardWriter::append(const void *data, std::size_t bytes)
+{
+  out_.write(static_cast<const char *>(data), static_cast<std::streamsize>(bytes));
+  if(!out_)
+  {
+    throw std::runtime_error("Failed to write columnar shard: " + path_);
+  }
+  offset_ += bytes;
+}
+
+void ColumnarShardWriter::write(const BarColumns &bars)
+{
+  Entry entry{ bars.symbol, bars.size(), {} };
+  for(std::size_t first = 0; first < bars.size(); first += chunkRows_)
+  {
+    const std::size_t rows = std::min(chunkRows_, bars.size() - first);
+    ColumnarChunk chunk{ offset_, rows, bars.time[first], bars.time[first + rows - 1], {} };
+
+    block_.clear();
+    chunk.columnBytes[0] = encodeColumn(bars.time.data() + first, rows, encoding_, block_);
+    const std::vector<double> *columns[] = { &bars.open, &bars.high, &bars.low, &bars.close,
+                                             &bars.volume };
+    for(std::size_t c = 0; c < 5; ++c)
+    {
+      chunk.columnBytes[c + 1] = encodeColumn(columns[c]->data() + first, rows, encoding_,
+                                              block_);
+    }
+    append(block_.data(), block_.size());
+    entry.chunks.push_back(chunk);
+  }
+  entries_.push_back(std::move(entry));
+}
+
+void ColumnarShardWriter::finish()
+{
+  const std::uint64_t footerOffset = offset_;
+  const auto count = static_cast<std::uint64_t>(entries_.size());
+  append(&count, sizeof(count));
+  for(const Entry &e : entries_)
+  {
+    const auto nameBytes = static_cast<std::uint64_t>(e.symbol.size());
+    append(&nameBytes, sizeof(nameBytes));
+    append(e.symbol.data(), e.symbol.size());
+    append(&e.rows, sizeof(e.rows));
+    const auto chunks = static_cast<std::uint64_t>(e.chunks.size());
+    append(&chunks, sizeof(chunks));
+    append(e.chunks.data(), e.chunks.size() * sizeof(ColumnarChunk));
+  }
+  append(&footerOffset, sizeof(footerOffset));
+  append(shardMagic, sizeof(shardMagic));
+  out_.close();
+}
+
+ColumnarShardReader::ColumnarShardReader(std::string path)
+  : path_(std::move(path))
+{
+  std::ifstream in(path_, std::ios::binary);
+  if(!in)
+  {
+    throw std::runtime_error("Failed to open columnar shard: " + path_);
+  }
+
+  const std::uint64_t size = std::filesystem::file_size(path_);
+  std::uint64_t footerOffset = 0;
+  char magic[sizeof(shardMagic)] = {};
+  if(size < sizeof(shardMagic) + trailerBytes)
+  {
+    throw std::runtime_error("Columnar shard is truncated: " + path_);
+  }
+  in.seekg(static_cast<std::streamoff>(size - trailerBytes));
+  readExact(in, &footerOffset, 1, path_);
+  readExact(in, magic, sizeof(magic), path_);
+  if(std::memcmp(magic, shardMagic, sizeof(magic)) != 0 || footerOffset > size - trailerBytes)
+  {
+    throw std::runtime_error("Not a columnar shard (or an unfinished one): " + path_);
+  }
+
+  in.seekg(static_cast<std::streamoff>(footerOffset));
+  std::uint64_t count = 0;
+  readExact(in, &count, 1, path_);
+  for(std::uint64_t i = 0; i < count; ++i)
+  {
+    std::uint64_t nameBytes = 0;
+    readExact(in, &nameBytes, 1, path_);
+    if(nameBytes > size)
+    {
+      throw std::runtime_error("Columnar shard footer is corrupt: " + path_);
+    }
+    std::string symbol(static_cast<std::size_t>(nameBytes), '\0');
+    readExact(in, symbol.data(), symbol.size(), path_);
+
+    Entry e{};
+    std::uint64_t chunks = 0;
+    readExact(in, &e.rows, 1, path_);
+    readExact(in, &chunks, 1, path_);
+    if(chunks > e.rows || chunks > size / sizeof(ColumnarChunk))
+    {
+      throw std::runtime_error("Columnar shard footer is corrupt: " + path_);
+    }
+    e.chunks.resize(static_cast<std::size_t>(chunks));
+    readExact(in, e.chunks.data(), e.chunks.size(), path_);
+
+    std::uint64_t rows = 0;
+    for(const ColumnarChunk &c : e.chunks)
+    {
+      rows += c.rows;
+      std::uint64_t end = c.offset;
+      for(std::uint64_t bytes : c.columnBytes)
+      {
+        end = bytes <= footerOffset ? end + bytes : footerOffset + 1;
+      }
+      if(end > footerOffset || c.rows > footerOffset)
+      {
+        throw std::runtime_error("Columnar shard footer is corrupt: " + path_);
+      }
+    }
+    if(rows != e.rows)
+    {
+      throw std::runtime_error("Columnar shard footer is corrupt: " + path_);
+    }
+    entries_.emplace(std::move(symbol), std::move(e));
+  }
+}
+
+std::vector<std::string> ColumnarShardReader::symbols() const
+{
+  std::vector<std::string> out;
+  out.reserve(entries_.size());
+  for(const auto &e : entries_)
+  {
+    out.push_back(e.first);
+  }
+  return out;
+}
+
+BarColumns ColumnarShardReader::read(const std::string &symbol, const TimeRange &range,
+                                     BarFields fields) const
+{
+  auto it = entries_.find(symbol);
+  if(it == entries_.end())
+  {
+    throw std::runtime_error("Columnar shard " + path_ + " has no symbol " + symbol);
+  }
+  const std::vector<ColumnarChunk> &chunks = it->second.chunks;
+
+  // Chunks are in time order: the first one ending at or after the start
+  // is found by binary search, and reading stops at the first one
+  // beginning after the end.
+  const auto begin = std::partition_point(chunks.begin(), chunks.end(),
+                                          [&](const ColumnarChunk &c)
+                                          { return c.last < range.start; });
+  const auto end = std::partition_point(begin, chunks.end(),
+                                        [&](const ColumnarChunk &c)
+                                        { return c.first <= range.end; });
+
+  BarColumns bars;
+  bars.symbol = symbol;
+  std::vector<double> *columns[] = { &bars.open, &bars.high, &bars.low, &bars.close,
+                                     &bars.volume };
+  const BarFields columnFields[] = { BarField::Open, BarField::High, BarField::Low,
+                                     BarField::Close, BarField::Volume };
+
+  std::size_t capacity = 0;
+  for(auto chunk = begin; chunk != end; ++chunk)
+  {
+    capacity += static_cast<std::size_t>(chunk->rows);
+  }
+  bars.time.reserve(capacity);
+  for(std::size_t c = 0; c < 5; ++c)
+  {
+    if(fields & columnFields[c])
+    {
+      columns[c]->reserve(capacity);
+    }
+  }
+
+  std::ifstream in(path_, std::ios::binary);
+  std::vector<std::uint8_t> block;
+  std::vector<std::int64_t> time;
+  std::vector<double> values;
+  auto readBlock = [&](std::uint64_t bytes)
+  {
+    block.resize(static_cast<std::size_t>(bytes));
+    readExact(in, block.data(), block.size(), path_);
+  };
+
+  for(auto chunk = begin; chunk != end; ++chunk)
+  {
+    const auto rows = static_cast<std::size_t>(chunk->rows);
+    time.resize(rows);
+    values.resize(rows);
+    in.seekg(static_cast<std::streamoff>(chunk->offset));
+    readBlock(chunk->columnBytes[0]);
+    decodeColumn(block.data(), block.size(), rows, time.data());
+
+    // Only the edge chunks hold rows outside the range.
+    const auto [firstRow, lastRow] = selectRows(time.data(), rows, range, 0);
+    const auto first = static_cast<std::ptrdiff_t>(firstRow);
+    const auto last = static_cast<std::ptrdiff_t>(lastRow);
+    bars.time.insert(bars.time.end(), time.begin() + first, time.begin() + last);
+
+    // Blocks follow the time column's in field order; skipped ones are
+    // seeked over, never read or decoded.
+    std::uint64_t next = chunk->offset + chunk->columnBytes[0];
+    bool contiguous = true;
+    for(std::size_t c = 0; c < 5; ++c)
+    {
+      const std::uint64_t bytes = chunk->columnBytes[c + 1];
+      if(!(fields & columnFields[c]))
+      {
+        next += bytes;
+        contiguous = false;
+        continue;
+      }
+      if(!contiguous)
+      {
+        in.seekg(static_cast<std::streamoff>(next));
+        contiguous = true;
+      }
+      readBlock(bytes);
+      next += bytes;
+      decodeColumn(block.data(), block.size(), rows, values.data());
+      columns[c]->insert(columns[c]->end(), values.begin() + first, values.begin() + last);
+    }
+  }
+  return bars;
+}
+
+void writeColumnarManifest(const std::string &directory,
+                           const std::vector<ColumnarManifestEntry> &entries)
+{
+  json symbols = json::object();
+  for(const auto &e : entries)
+  {
+    symbols[e.symbol] = { { "shard", e.shard },
+                          { "rows", e.rows },
+                          { "first", formatTimestamp(e.first) },
+                          { "last", formatTimestamp(e.last) } };
+  }
+  json manifest = { { "format", "backtest-columnar" }, { "version", 3 }, { "symbols", symbols } };
+
+  // Write-then-rename: a reader never sees a half-written manifest.
+  const std::string path = (std::filesystem::path(directory) / manifestName).string();
+  const std::string tmp = path + ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::trunc);
+    if(!out)
+    {
+      throw std::runtime_error("Failed to write columnar manifest: " + tmp);
+    }
+    out << manifest.dump(2) << "\n";
+  }
+  std::filesystem::rename(tmp, path);
+}
+
+ColumnarDataset::ColumnarDataset(std::string directory)
+  : directory_(std::move(directory))
+{
+  const std::string path = (std::filesystem::path(directory_) / manifestName).string();
+  std::ifstream in(path);
+  if(!in)
+  {
+    throw std::runtime_error("Failed to open columnar manifest: " + path);
+  }
+
+  json manifest;
+  in >> manifest;
+  if(manifest.value("format", std::string{}) != "backtest-columnar")
+  {
+    throw std::runtime_error("Not a columnar dataset manifest: " + path);
+  }
+  if(manifest.value("version", 0) != 3)
+  {
+    throw std::runtime_error("Unsupported columnar dataset version (re-run backtest_import): "
+                             + path);
+  }
+
+  for(const auto &[symbol, e] : manifest.at("symbols").items())
+  {
+    index_.emplace(symbol, entries_.size());
+    entries_.push_back({ symbol, e.at("shard").get<std::string>(),
+                         e.at("rows").get<std::uint64_t>(),
+                         parseTimestamp(e.at("first").get<std::string>()),
+                         parseTimestamp(e.at("last").get<std::string>()) });
+  }
+}
+
+const ColumnarManifestEntry &ColumnarDataset::entry(const std::string &symbol) const
+{
+  auto it = index_.find(symbol);
+  if(it == index_.end())
+  {
+    throw std::runtime_error("Columnar dataset " + directory_ + " has no symbol " + symbol);
+  }
+  return entries_[it->second];
+}
+
+const ColumnarShardReader &ColumnarDataset::shard(const std::string &file) const
+{
+  std::lock_guard<std::mutex> lock(shardsMutex_);
+  auto &reader = shards_[file];
+  if(!reader)
+  {
+    reader = std::make_unique<ColumnarShardReader>(
+      (std::filesystem::path(directory_) / file).string());
+  }
+  return *reader;
+}
+
+BarColumns ColumnarDataset::columns(const std::string &symbol, const TimeRange &range,
+                                    BarFields fields) const
+{
+  const ColumnarManifestEntry &e = entry(symbol);
+  if(e.last < range.start || e.first > range.end)
+  {
+    // Disjoint ranges are settled by the manifest without opening the shard.
+    BarColumns none;
+    none.symbol = symbol;
+    return none;
+  }
+  return shard(e.shard).read(symbol, range, fields);
+}
+
+std::vector<Candle> ColumnarDataset::load(const std::string &symbol, int lookbackBars,
+                                          const TimeRange &range, BarFields fields) const
+{
+  BarColumns bars = columns(symbol, range, fields);
+  const std::size_t first = selectRows(bars.time.data(), bars.size(), {}, lookbackBars).first;
+
+  // Projected-out columns are empty.
+  auto at = [](const std::vector<double> &column, std::size_t i)
+  { return column.empty() ? 0.0 : column[i]; };
+
+  std::vector<Candle> candles;
+  candles.reserve(bars.size() - first);
+  for(std::size_t i = first; i < bars.size(); ++i)
+  {
+    candles.push_back({ formatTimestamp(bars.time[i]), symbol, at(bars.open, i),
+                        at(bars.high, i), at(bars.low, i), at(bars.close, i),
+                        at(bars.volume, i) });
+  }
+  return candles;
+}
@@ -0,0 +1,29 @@
+#include "EnginePhase.hpp"
+
+const char *enginePhaseName(EnginePhase phase)
+{
+  switch(phase)
+  {
+  case EnginePhase::Outside:
+    return "outside run";
+  case EnginePhase::Setup:
+    return "setup";
+  case EnginePhase::Feed:
+    return "feed";
+  case EnginePhase::Strategy:
+    return "strategy";
+  case EnginePhase::Execution:
+    return "execution";
+  case EnginePhase::Ledger:
+    return "ledger";
+  case EnginePhase::MarkToMarket:
+    return "mark to market";
+  case EnginePhase::Metrics:
+    return "metrics";
+  case EnginePhase::Teardown:
+    return "teardown";
+  case EnginePhase::Count:
+    break;
+  }
+  return "?";
+}
@@ -0,0 +1,16 @@
+#include "FileUtil.hpp"
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <unistd.h>
+
+std::string uniqueTempPath(const std::string &path)
+{
+  // The counter separates successive writes of one thread whose temporary
+  // outlived a failed rename.
+  static std::atomic<unsigned long> counter{ 0 };
+  return path + ".tmp." + std::to_string(::getpid()) + "."
+         + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + "."
+         + std::to_string(counter++);
+}
@@ -0,0 +1,214 @@
+#include "HttpFetcher.hpp"
+
+#include <curl/curl.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+
+namespace
+{
+
+std::once_flag curlGlobalInit;
+
+size_t writeCallback(char *ptr, size_t size, size_t nmemb, void *userdata)
+{
+  std::size_t totalSize = size * nmemb;
+  auto *buffer = static_cast<std::string *>(userdata);
+  buffer->append(ptr, totalSize);
+  return totalSize;
+}
+
+bool retryable(CURLcode result, long status)
+{
+  return result != CURLE_OK || status == 429 || status >= 500;
+}
+
+struct Pending
+{
+  std::size_t index;
+  std::chrono::steady_clock::time_point notBefore;
+};
+
+} // namespace
+
+HttpFetcher::HttpFetcher(HttpFetchOptions options)
+  : options_(options)
+{
+  std::call_once(curlGlobalInit, [] { curl_global_init(CURL_GLOBAL_DEFAULT); });
+  options_.concurrency = std::max<std::size_t>(options_.concurrency, 1);
+
+  multi_ = curl_multi_init();
+  share_ = curl_share_init();
+  if(multi_ == nullptr || share_ == nullptr)
+  {
+    curl_multi_cleanup(multi_);
+    curl_share_cleanup(share_);
+    throw std::runtime_error("Failed to initialize CURL");
+  }
+
+  // Connections live in the multi handle's cache; name lookups and TLS
+  // sessions are shared through the share handle so resumed handshakes
+  // are cheap too.
+  curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+  curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+
+  const auto connections = static_cast<long>(options_.concurrency);
+  curl_multi_setopt(multi_, CURLMOPT_MAX_TOTAL_CONNECTIONS, connections);
+  curl_multi_setopt(multi_, CURLMOPT_MAXCONNECTS, connections);
+  curl_multi_setopt(multi_, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+}
+
+HttpFetcher::~HttpFetcher()
+{
+  for(void *handle : idle_)
+  {
+    curl_easy_cleanup(handle);
+  }
+  curl_multi_cleanup(multi_);
+  curl_share_cleanup(share_);
+}
+
+void *HttpFetcher::acquireHandle()
+{
+  if(!idle_.empty())
+  {
+    void *handle = idle_.back();
+    idle_.pop_back();
+    return handle;
+  }
+
+  CURL *curl = curl_easy_init();
+  if(curl == nullptr)
+  {
+    throw std::runtime_error("Failed to initialize CURL");
+  }
+
+  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
+  curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+  curl_easy_setopt(curl, CURLOPT_SHARE, share_);
+  curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+  curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+  curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, static_cast<long>(options_.timeout.count()));
+
+  // Empty string: advertise every encoding this libcurl can decode
+  // (gzip and deflate at least).
+  curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
+
+  curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 1L);
+  curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 2L);
+  curl_easy_setopt(curl, CURLOPT_CAINFO, "/etc/ssl/certs/ca-certificates.crt");
+  curl_easy_setopt(curl, CURLOPT_CAPATH, "/etc/ssl/certs");
+  return curl;
+}
+
+std::vector<HttpResponse> HttpFetcher::fetchAll(const std::vector<std::string> &urls)
+{
+  using Clock = std::chrono::steady_clock;
+  const auto spacing = std::chrono::duration_cast<Clock::duration>(
+    std::chrono::duration<double>(options_.requestsPerMinute > 0.0
+                                    ? 60.0 / options_.requestsPerMinute
+                                    : 0.0));
+
+  std::vector<HttpResponse> responses(urls.size());
+  std::vector<std::size_t> attempts(urls.size());
+  std::deque<Pending> pending;
+  for(std::size_t i = 0; i < urls.size(); ++i)
+  {
+    pending.push_back({ i, Clock::time_point{} });
+  }
+
+  std::size_t running = 0;
+  while(!pending.empty() || running > 0)
+  {
+    // Start what the concurrency cap and the rate schedule allow.
+    Clock::time_point now = Clock::now();
+    while(!pending.empty() && running < options_.concurrency
+          && std::max(nextStart_, pending.front().notBefore) <= now)
+    {
+      const std::size_t i = pending.front().index;
+      pending.pop_front();
+
+      CURL *curl = acquireHandle();
+      responses[i] = {};
+      curl_easy_setopt(curl, CURLOPT_URL, urls[i].c_str());
+      curl_easy_setopt(curl, CURLOPT_WRITEDATA, &responses[i].body);
+      curl_easy_setopt(curl, CURLOPT_PRIVATE, reinterpret_cast<void *>(std::uintptr_t{ i }));
+      curl_multi_add_handle(multi_, curl);
+      ++running;
+      nextStart_ = std::max(nextStart_, now) + spacing;
+    }
+
+    int stillRunning = 0;
+    curl_multi_perform(multi_, &stillRunning);
+
+    int queued = 0;
+    while(CURLMsg *msg = curl_multi_info_read(multi_, &queued))
+    {
+      if(msg->msg != CURLMSG_DONE)
+      {
+        continue;
+      }
+
+      CURL *curl = msg->easy_handle;
+      const CURLcode result = msg->data.result;
+      void *tag = nullptr;
+      long status = 0;
+      long connects = 0;
+      curl_easy_getinfo(curl, CURLINFO_PRIVATE, &tag);
+      curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+      curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+      curl_multi_remove_handle(multi_, curl);
+      idle_.push_back(curl);
+      --running;
+      connectionsOpened_ += static_cast<std::size_t>(connects);
+
+      const auto i = static_cast<std::size_t>(reinterpret_cast<std::uintptr_t>(tag));
+      HttpResponse &response = responses[i];
+      if(retryable(result, status) && attempts[i] < options_.retries)
+      {
+        // Back off 0.5 s, 1 s, 2 s, ... on top of the rate schedule.
+        pending.push_back({ i, Clock::now() + std::chrono::milliseconds(500 << attempts[i]) });
+        ++attempts[i];
+        continue;
+      }
+
+      response.status = result == CURLE_OK ? status : 0;
+      if(result != CURLE_OK)
+      {
+        response.error = std::string("CURL error: ") + curl_easy_strerror(result);
+      }
+      else if(status != 200)
+      {
+        response.error = "HTTP error code " + std::to_string(status);
+      }
+    }
+
+    // Sleep until a transfer needs attention or the next start is due.
+    int timeoutMs = 1000;
+    if(!pending.empty() && running < options_.concurrency)
+    {
+      auto due = std::max(nextStart_, pending.front().notBefore) - Clock::now();
+      timeoutMs = static_cast<int>(std::clamp<std::int64_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(due).count(), 0, 1000));
+    }
+    if(running > 0 || (!pending.empty() && timeoutMs > 0))
+    {
+      curl_multi_poll(multi_, nullptr, 0, timeoutMs, nullptr);
+    }
+  }
+
+  return responses;
+}
+
+std::string HttpFetcher::get(const std::string &url)
+{
+  HttpResponse response = std::move(fetchAll({ url }).front());
+  if(!response.ok())
+  {
+    throw std::runtime_error(response.error);
+  }
+  return std::move(response.body);
+}
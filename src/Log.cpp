@@ -0,0 +1,405 @@
+#include "Log.hpp"
+#include "AllocTracker.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+struct RecordHeader
+{
+  std::int64_t time;
+  const char *format;
+  const char *tagName; // nullptr without a LogContext
+  std::int64_t tagId;
+  std::uint32_t size; // header and arguments
+  LogLevel level;
+  std::uint8_t argCount;
+};
+
+// A writing thread's records. The writer appends to `buffer` under
+// `mutex`; the drain thread swaps it with `spare`, which only it touches,
+// so both keep their capacity and steady-state logging does not allocate.
+struct ThreadLog
+{
+  std::mutex mutex;
+  std::vector<char> buffer;
+  std::vector<char> spare;
+  bool exited{};
+};
+
+class Logger
+{
+public:
+  static Logger &instance()
+  {
+    static Logger logger;
+    return logger;
+  }
+
+  std::shared_ptr<ThreadLog> attach()
+  {
+    auto log = std::make_shared<ThreadLog>();
+    std::lock_guard<std::mutex> lock(mutex_);
+    threads_.push_back(log);
+    return log;
+  }
+
+  void setSink(std::ostream *out)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sink_ = out;
+  }
+
+  void flush()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    const std::uint64_t ticket = ++requested_;
+    wake_.notify_one();
+    drained_.wait(lock, [&] { return completed_ >= ticket; });
+  }
+
+  ~Logger()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_one();
+    worker_.join();
+  }
+
+private:
+  struct Entry
+  {
+    std::int64_t time;
+    const char *record;
+  };
+
+  Logger()
+    : worker_([this] { run(); })
+  {
+  }
+
+  void run()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for(;;)
+    {
+      wake_.wait_for(lock, std::chrono::milliseconds(20),
+                     [&] { return stop_ || requested_ > completed_; });
+      const std::uint64_t ticket = requested_;
+      const bool stopping = stop_;
+      std::ostream *sink = sink_;
+      batch_ = threads_;
+
+      lock.unlock();
+      drain(sink);
+      lock.lock();
+
+      // Forget threads that have exited and whose records are all out.
+      threads_.erase(std::remove_if(threads_.begin(), threads_.end(),
+                                    [](const std::shared_ptr<ThreadLog> &t)
+                                    {
+                                      std::lock_guard<std::mutex> guard(t->mutex);
+                                      return t->exited && t->buffer.empty();
+                                    }),
+                     threads_.end());
+      batch_.clear();
+
+      completed_ = ticket;
+      drained_.notify_all();
+      if(stopping)
+      {
+        return;
+      }
+    }
+  }
+
+  void drain(std::ostream *sink)
+  {
+    entries_.clear();
+    for(const auto &t : batch_)
+    {
+      t->spare.clear();
+      {
+        std::lock_guard<std::mutex> guard(t->mutex);
+        t->buffer.swap(t->spare);
+      }
+
+      for(std::size_t at = 0; at + sizeof(RecordHeader) <= t->spare.size();)
+      {
+        RecordHeader header;
+        std::memcpy(&header, t->spare.data() + at, sizeof(header));
+        entries_.push_back({ header.time, t->spare.data() + at });
+        at += header.size;
+      }
+    }
+    if(entries_.empty())
+    {
+      return;
+    }
+
+    // Interleave the threads' records in time order.
+    std::stable_sort(entries_.begin(), entries_.end(),
+                     [](const Entry &a, const Entry &b) { return a.time < b.time; });
+    for(const Entry &e : entries_)
+    {
+      format(e.record, sink);
+    }
+
+    (sink != nullptr ? *sink : std::cout).flush();
+    if(sink == nullptr)
+    {
+      std::cerr.flush();
+    }
+  }
+
+  void format(const char *record, std::ostream *sink)
+  {
+    RecordHeader header;
+    std::memcpy(&header, record, sizeof(header));
+    const char *end = record + header.size;
+    const char *at = record + sizeof(header);
+
+    std::ostream &out = sink != nullptr ? *sink
+                        : header.level == LogLevel::Info ? std::cout
+                                                         : std::cerr;
+    if(header.level != LogLevel::Info)
+    {
+      out << '[' << logLevelName(header.level) << "] ";
+    }
+    if(header.tagName != nullptr)
+    {
+      out << '[' << header.tagName;
+      if(header.tagId >= 0)
+      {
+        out << ' ' << header.tagId;
+      }
+      out << "] ";
+    }
+
+    std::size_t remaining = header.argCount;
+    for(const char *f = header.format; *f != '\0'; ++f)
+    {
+      if(f[0] == '{' && f[1] == '}' && remaining > 0 && at < end)
+      {
+        at = formatArg(at, out);
+        --remaining;
+        ++f;
+      }
+      else
+      {
+        out << *f;
+      }
+    }
+    out << '\n';
+  }
+
+  static const char *formatArg(const char *at, std::ostream &out)
+  {
+    auto type = static_cast<LogRecordWriter::Type>(*at++);
+    switch(type)
+    {
+    case LogRecordWriter::Type::Int:
+    {
+      std::int64_t v;
+      std::memcpy(&v, at, sizeof(v));
+      out << v;
+      return at + sizeof(v);
+    }
+    case LogRecordWriter::Type::UInt:
+    {
+      std::uint64_t v;
+      std::memcpy(&v, at, sizeof(v));
+      out << v;
+      return at + sizeof(v);
+    }
+    case LogRecordWriter::Type::Double:
+    {
+      double v;
+      std::memcpy(&v, at, sizeof(v));
+      out << v;
+      return at + sizeof(v);
+    }
+    case LogRecordWriter::Type::Bool:
+    {
+      std::uint64_t v;
+      std::memcpy(&v, at, sizeof(v));
+      out << (v != 0 ? "true" : "false");
+      return at + sizeof(v);
+    }
+    case LogRecordWriter::Type::String:
+    {
+      std::uint32_t n;
+      std::memcpy(&n, at, sizeof(n));
+      out.write(at + sizeof(n), n);
+      return at + sizeof(n) + n;
+    }
+    }
+    return at;
+  }
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable drained_;
+  std::vector<std::shared_ptr<ThreadLog>> threads_;
+  std::uint64_t requested_{};
+  std::uint64_t completed_{};
+  bool stop_{};
+  std::ostream *sink_{};
+
+  // Drain thread only.
+  std::vector<std::shared_ptr<ThreadLog>> batch_;
+  std::vector<Entry> entries_;
+
+  std::thread worker_;
+};
+
+// Marks the thread's log as exited so the drain thread can drop it once
+// its last records are written.
+struct ThreadHandle
+{
+  std::shared_ptr<ThreadLog> log;
+  const char *tagName{};
+  std::int64_t tagId{ -1 };
+
+  ~ThreadHandle()
+  {
+    if(log)
+    {
+      std::lock_guard<std::mutex> lock(log->mutex);
+      log->exited = true;
+    }
+  }
+};
+
+thread_local ThreadHandle threadHandle;
+
+std::int64_t nowNanos()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch())
+    .count();
+}
+
+} // namespace
+
+const char *logLevelName(LogLevel level)
+{
+  switch(level)
+  {
+  case LogLevel::Debug:
+    return "debug";
+  case LogLevel::Info:
+    return "info";
+  case LogLevel::Warn:
+    return "warn";
+  case LogLevel::Error:
+    return "error";
+  case LogLevel::Off:
+    return "off";
+  }
+  return "?";
+}
+
+LogLevel parseLogLevel(const std::string &name)
+{
+  for(LogLevel level : { LogLevel::Debug, LogLevel::Info, LogLevel::Warn, LogLevel::Error,
+                         LogLevel::Off })
+  {
+    if(name == logLevelName(level))
+    {
+      return level;
+    }
+  }
+  throw std::runtime_error("Unsupported log level: " + name);
+}
+
+void Log::setSink(std::ostream *out)
+{
+  Logger::instance().setSink(out);
+}
+
+void Log::flush()
+{
+  Logger::instance().flush();
+}
+
+LogContext::LogContext(const char *name, std::int64_t id)
+  : previousName_(threadHandle.tagName), previousId_(threadHandle.tagId)
+{
+  threadHandle.tagName = name;
+  threadHandle.tagId = id;
+}
+
+LogContext::~LogContext()
+{
+  threadHandle.tagName = previousName_;
+  threadHandle.tagId = previousId_;
+}
+
+LogRecordWriter::LogRecordWriter(LogLevel level, const char *format, std::size_t argCount)
+{
+  if(!threadHandle.log)
+  {
+    AllocAllowScope allow;
+    threadHandle.log = Logger::instance().attach();
+  }
+
+  ThreadLog &log = *threadHandle.log;
+  log.mutex.lock();
+  log_ = &log;
+  start_ = log.buffer.size();
+
+  try
+  {
+    const RecordHeader header{ nowNanos(), format, threadHandle.tagName, threadHandle.tagId,
+                               0, level, static_cast<std::uint8_t>(argCount) };
+    append(&header, sizeof(header));
+  }
+  catch(...)
+  {
+    log.buffer.resize(start_);
+    log.mutex.unlock();
+    throw;
+  }
+}
+
+LogRecordWriter::~LogRecordWriter()
+{
+  auto &log = *static_cast<ThreadLog *>(log_);
+  const auto size = static_cast<std::uint32_t>(log.buffer.size() - start_);
+  std::memcpy(log.buffer.data() + start_ + offsetof(RecordHeader, size), &size, sizeof(size));
+  log.mutex.unlock();
+}
+
+void LogRecordWriter::putString(std::string_view text)
+{
+  const Type type = Type::String;
+  const auto n = static_cast<std::uint32_t>(text.size());
+  append(&type, 1);
+  append(&n, sizeof(n));
+  append(text.data(), n);
+}
+
+void LogRecordWriter::append(const void *data, std::size_t n)
+{
+  std::vector<char> &buffer = static_cast<ThreadLog *>(log_)->buffer;
+  if(buffer.size() + n > buffer.capacity())
+  {
+    // Log buffers grow amortized, like ledger chunks.
+    AllocAllowScope allow;
+    buffer.reserve(std::max(buffer.capacity() * 2, buffer.size() + n + 4096));
+  }
+  const char *bytes = static_cast<const char *>(data);
+  buffer.insert(buffer.end(), bytes, bytes + n);
+}
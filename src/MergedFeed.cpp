@@ -0,0 +1,109 @@
+#include "feed/MergedFeed.hpp"
+#include "Timestamp.hpp"
+
+#include <algorithm>
+#include <queue>
+#include <stdexcept>
+
+MergedFeed::MergedFeed(std::vector<std::vector<Candle>> series)
+{
+  if(series.size() >= sliceEndBit)
+  {
+    throw std::invalid_argument("MergedFeed: too many series");
+  }
+
+  // Parse every timestamp once so the heap compares integers, not strings.
+  std::size_t total = 0;
+  std::vector<std::vector<std::int64_t>> keys(series.size());
+  symbols_.reserve(series.size());
+  for(std::size_t s = 0; s < series.size(); ++s)
+  {
+    const auto &bars = series[s];
+    keys[s].reserve(bars.size());
+    for(const auto &bar : bars)
+    {
+      keys[s].push_back(parseTimestamp(bar.timestamp));
+      if(keys[s].size() > 1 && keys[s].back() < keys[s][keys[s].size() - 2])
+      {
+        throw std::invalid_argument("MergedFeed: series for " + bar.symbol
+                                    + " is not sorted by timestamp");
+      }
+    }
+    symbols_.push_back(bars.empty() ? std::string{} : bars.front().symbol);
+    total += bars.size();
+  }
+
+  // Heap of each series' next unmerged bar. Ties are broken by series
+  // index so the merged order is deterministic.
+  struct Head
+  {
+    std::int64_t key;
+    std::uint32_t series;
+    std::size_t row;
+  };
+  auto later = [](const Head &a, const Head &b)
+  {
+    return a.key != b.key ? a.key > b.key : a.series > b.series;
+  };
+  std::priority_queue<Head, std::vector<Head>, decltype(later)> heap(later);
+
+  for(std::size_t s = 0; s < series.size(); ++s)
+  {
+    if(!series[s].empty())
+    {
+      heap.push({ keys[s].front(), static_cast<std::uint32_t>(s), 0 });
+    }
+  }
+
+  candles_.reserve(total);
+  tags_.reserve(total);
+  std::int64_t prevKey = 0;
+  while(!heap.empty())
+  {
+    Head h = heap.top();
+    heap.pop();
+
+    if(!tags_.empty() && prevKey == h.key)
+    {
+      tags_.back() &= ~sliceEndBit;
+    }
+    candles_.push_back(std::move(series[h.series][h.row]));
+    tags_.push_back(h.series | sliceEndBit);
+    prevKey = h.key;
+
+    std::size_t nextRow = h.row + 1;
+    if(nextRow < series[h.series].size())
+    {
+      heap.push({ keys[h.series][nextRow], h.series, nextRow });
+    }
+  }
+}
+
+bool MergedFeed::hasNext() const
+{
+  return index_ < candles_.size();
+}
+
+const Candle &MergedFeed::next()
+{
+  if(!hasNext())
+  {
+    throw std::out_of_range("MergedFeed::next called with no more data");
+  }
+  return candles_[index_++];
+}
+
+void MergedFeed::skip(std::size_t count)
+{
+  index_ = std::min(candles_.size(), index_ + count);
+}
+
+bool MergedFeed::endOfSlice() const
+{
+  return index_ == 0 || (tags_[index_ - 1] & sliceEndBit) != 0;
+}
+
+std::size_t MergedFeed::lastSymbolId() const
+{
+  return index_ == 0 ? 0 : (tags_[index_ - 1] & ~sliceEndBit);
+}
@@ -1,19 +1,33 @@
 #include "Metrics.hpp"
+#include "Checkpoint.hpp"
+#include "Trace.hpp"
 #include <algorithm>
 #include <cmath>
 #include <vector>
 
-void Metrics::recordStep(const Portfolio &p, const std::string &ts)
+Snapshot makeSnapshot(const Portfolio &p, const std::string &ts)
 {
   Snapshot s;
   s.timestamp = ts;
-  s.equity = p.getEquity();
+  Portfolio::Valuation v = p.valuation();
+  s.equity = v.equity;
   s.cash = p.getCash();
-  snapshots_.push_back(s);
+  s.realizedPnL = p.getRealizedPnL();
+  s.unrealizedPnL = v.unrealizedPnL;
+  return s;
+}
+
+void Metrics::recordStep(const Portfolio &p, const std::string &ts)
+{
+  // The equity curve grows by design (amortized, geometric growth), and
+  // long timestamps are copied into each snapshot.
+  AllocAllowScope allow;
+  snapshots_.push_back(makeSnapshot(p, ts));
 }
 
 Report Metrics::computeReport() const
 {
+  TraceScope trace("compute report");
   Report r{};
   if(snapshots_.empty())
   {
@@ -23,6 +37,8 @@ Report Metrics::computeReport() const
   const std::size_t n = snapshots_.size();
   double start = snapshots_.front().equity;
   double end = snapshots_.back().equity;
+  r.realizedPnL = snapshots_.back().realizedPnL;
+  r.unrealizedPnL = snapshots_.back().unrealizedPnL;
 
   if(start > 0.0)
   {
@@ -94,3 +110,33 @@ Report Metrics::computeReport() const
 
   return r;
 }
+
+void Metrics::saveState(CheckpointWriter &out) const
+{
+  out.writeU64(snapshots_.size());
+  for(const auto &s : snapshots_)
+  {
+    out.writeString(s.timestamp);
+    out.writeDouble(s.equity);
+    out.writeDouble(s.cash);
+    out.writeDouble(s.realizedPnL);
+    out.writeDouble(s.unrealizedPnL);
+  }
+}
+
+void Metrics::loadState(CheckpointReader &in)
+{
+  snapshots_.clear();
+  std::uint64_t count = in.readU64();
+  snapshots_.reserve(static_cast<std::size_t>(count));
+  for(std::uint64_t i = 0; i < count; ++i)
+  {
+    Snapshot s;
+    s.timestamp = in.readString();
+    s.equity = in.readDouble();
+    s.cash = in.readDouble();
+    s.realizedPnL = in.readDouble();
+    s.unrealizedPnL = in.readDouble();
+    snapshots_.push_back(s);
+  }
+}
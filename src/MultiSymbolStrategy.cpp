@@ -0,0 +1,72 @@
+#include "MultiSymbolStrategy.hpp"
+#include "Checkpoint.hpp"
+
+#include <stdexcept>
+
+void MultiSymbolStrategy::add(const std::string &symbol,
+                              std::unique_ptr<Strategy_I> strategy)
+{
+  if(!bySymbol_.emplace(symbol, strategies_.size()).second)
+  {
+    throw std::invalid_argument("Duplicate symbol in strategy universe: " + symbol);
+  }
+  strategies_.push_back(std::move(strategy));
+}
+
+void MultiSymbolStrategy::onStart(BacktestEngine &engine)
+{
+  for(auto &s : strategies_)
+  {
+    s->onStart(engine);
+  }
+}
+
+void MultiSymbolStrategy::onBar(std::size_t index,
+                                const Candle &bar,
+                                BacktestEngine &engine)
+{
+  auto it = bySymbol_.find(bar.symbol);
+  if(it != bySymbol_.end())
+  {
+    strategies_[it->second]->onBar(index, bar, engine);
+  }
+}
+
+void MultiSymbolStrategy::onEnd(BacktestEngine &engine)
+{
+  for(auto &s : strategies_)
+  {
+    s->onEnd(engine);
+  }
+}
+
+BarFields MultiSymbolStrategy::barFields() const
+{
+  BarFields fields = 0;
+  for(const auto &s : strategies_)
+  {
+    fields |= s->barFields();
+  }
+  return fields;
+}
+
+void MultiSymbolStrategy::saveState(CheckpointWriter &out) const
+{
+  out.writeU64(strategies_.size());
+  for(const auto &s : strategies_)
+  {
+    s->saveState(out);
+  }
+}
+
+void MultiSymbolStrategy::loadState(CheckpointReader &in)
+{
+  if(in.readU64() != strategies_.size())
+  {
+    throw std::runtime_error("Checkpoint was written for a different symbol universe");
+  }
+  for(auto &s : strategies_)
+  {
+    s->loadState(in);
+  }
+}
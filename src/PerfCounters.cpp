@@ -0,0 +1,326 @@
+#include "PerfCounters.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+const char *perfEventName(PerfEvent event)
+{
+  switch(event)
+  {
+  case PerfEvent::Cycles:
+    return "cycles";
+  case PerfEvent::Instructions:
+    return "instructions";
+  case PerfEvent::L1dMisses:
+    return "L1d misses";
+  case PerfEvent::LlcMisses:
+    return "LLC misses";
+  case PerfEvent::BranchMisses:
+    return "branch misses";
+  case PerfEvent::Count:
+    break;
+  }
+  return "?";
+}
+
+PerfSample &PerfSample::operator+=(const PerfSample &other)
+{
+  for(std::size_t i = 0; i < perfEventCount; ++i)
+  {
+    value[i] += other.value[i];
+  }
+  return *this;
+}
+
+PerfSample &PerfSample::operator-=(const PerfSample &other)
+{
+  for(std::size_t i = 0; i < perfEventCount; ++i)
+  {
+    value[i] -= other.value[i];
+  }
+  return *this;
+}
+
+#if defined(__linux__)
+
+namespace
+{
+
+struct EventConfig
+{
+  std::uint32_t type;
+  std::uint64_t config;
+};
+
+constexpr EventConfig eventConfigs[perfEventCount] = {
+  { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+  { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+  { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D
+                          | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                          | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+  { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+  { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+};
+
+int openEvent(const EventConfig &event, int groupFd)
+{
+  perf_event_attr attr{};
+  attr.size = sizeof(attr);
+  attr.type = event.type;
+  attr.config = event.config;
+  attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED
+                     | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+
+  // This thread, any CPU.
+  return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0));
+}
+
+std::string explain(int error)
+{
+  std::string text = std::string("perf_event_open: ") + std::strerror(error);
+  switch(error)
+  {
+  case ENOENT:
+  case ENODEV:
+  case EOPNOTSUPP:
+    text += " (no hardware PMU exposed; common in containers and VMs)";
+    break;
+  case EACCES:
+  case EPERM:
+  {
+    std::ifstream paranoid("/proc/sys/kernel/perf_event_paranoid");
+    int level = 0;
+    if(paranoid >> level)
+    {
+      text += " (kernel.perf_event_paranoid is " + std::to_string(level) + ")";
+    }
+    break;
+  }
+  case ENOSYS:
+    text += " (kernel built without perf events)";
+    break;
+  default:
+    break;
+  }
+  return text;
+}
+
+} // namespace
+
+PerfCounters::PerfCounters()
+{
+  int firstError = 0;
+  std::string missing;
+  std::size_t slot = 0;
+
+  for(std::size_t i = 0; i < perfEventCount; ++i)
+  {
+    fds_[i] = openEvent(eventConfigs[i], leader_);
+    if(fds_[i] < 0)
+    {
+      if(firstError == 0)
+      {
+        firstError = errno;
+      }
+      missing += missing.empty() ? "" : ", ";
+      missing += perfEventName(static_cast<PerfEvent>(i));
+      continue;
+    }
+
+    if(leader_ < 0)
+    {
+      leader_ = fds_[i];
+    }
+    events_ |= 1u << i;
+    slot_[i] = slot++;
+  }
+
+  if(!available())
+  {
+    status_ = explain(firstError);
+  }
+  else if(!missing.empty())
+  {
+    status_ = "not counted: " + missing + "; " + explain(firstError);
+  }
+}
+
+PerfCounters::~PerfCounters()
+{
+  for(int fd : fds_)
+  {
+    if(fd >= 0)
+    {
+      ::close(fd);
+    }
+  }
+}
+
+PerfSample PerfCounters::read() const
+{
+  PerfSample sample;
+  if(!available())
+  {
+    return sample;
+  }
+
+  // PERF_FORMAT_GROUP layout: nr, time_enabled, time_running, values[nr].
+  std::uint64_t buffer[3 + perfEventCount]{};
+  if(::read(leader_, buffer, sizeof(buffer)) < static_cast<ssize_t>(3 * sizeof(std::uint64_t)))
+  {
+    return sample;
+  }
+
+  const std::uint64_t enabled = buffer[1];
+  const std::uint64_t running = buffer[2];
+  for(std::size_t i = 0; i < perfEventCount; ++i)
+  {
+    if(!has(static_cast<PerfEvent>(i)))
+    {
+      continue;
+    }
+
+    const std::uint64_t raw = buffer[3 + slot_[i]];
+    sample.value[i] = running > 0 && running < enabled
+                        ? static_cast<std::uint64_t>(static_cast<double>(raw)
+                                                     * static_cast<double>(enabled)
+                                                     / static_cast<double>(running))
+                        : raw;
+  }
+  return sample;
+}
+
+#else
+
+PerfCounters::PerfCounters()
+  : status_("hardware counters need Linux perf_event_open")
+{
+  for(int &fd : fds_)
+  {
+    fd = -1;
+  }
+}
+
+PerfCounters::~PerfCounters() = default;
+
+PerfSample PerfCounters::read() const
+{
+  return {};
+}
+
+#endif
+
+namespace
+{
+
+double perBar(std::uint64_t value, std::size_t bars)
+{
+  return bars > 0 ? static_cast<double>(value) / static_cast<double>(bars) : 0.0;
+}
+
+double ipc(const PerfSample &sample)
+{
+  const std::uint64_t cycles = sample[PerfEvent::Cycles];
+  return cycles > 0 ? static_cast<double>(sample[PerfEvent::Instructions])
+                        / static_cast<double>(cycles)
+                    : 0.0;
+}
+
+} // namespace
+
+void writePerfReport(std::ostream &out, const PerfReport &report)
+{
+  if(!report.available)
+  {
+    out << "Hardware counters unavailable: " << report.status << "\n";
+    return;
+  }
+
+  auto counted = [&](PerfEvent event)
+  { return (report.events >> static_cast<unsigned>(event)) & 1u; };
+  const bool hasIpc = counted(PerfEvent::Cycles) && counted(PerfEvent::Instructions);
+
+  const auto flags = out.flags();
+  const auto precision = out.precision();
+  out << std::fixed << std::setprecision(1);
+
+  out << "Hardware counters (engine thread, " << report.bars << " bars):\n";
+  out << "  " << std::left << std::setw(16) << "event" << std::right
+      << std::setw(16) << "per run" << std::setw(14) << "per bar" << "\n";
+  for(std::size_t i = 0; i < perfEventCount; ++i)
+  {
+    const auto event = static_cast<PerfEvent>(i);
+    if(!counted(event))
+    {
+      continue;
+    }
+    out << "  " << std::left << std::setw(16) << perfEventName(event) << std::right
+        << std::setw(16) << report.total[event]
+        << std::setw(14) << perBar(report.total[event], report.bars) << "\n";
+  }
+  if(hasIpc)
+  {
+    out << "  " << std::left << std::setw(16) << "IPC" << std::right
+        << std::setw(30) << std::setprecision(2) << ipc(report.total) << "\n"
+        << std::setprecision(1);
+  }
+  if(!report.status.empty())
+  {
+    out << "  " << report.status << "\n";
+  }
+
+  if(report.mode == PerfMode::Phases)
+  {
+    out << "  per bar by phase:\n  " << std::left << std::setw(16) << "phase" << std::right;
+    for(std::size_t i = 0; i < perfEventCount; ++i)
+    {
+      if(counted(static_cast<PerfEvent>(i)))
+      {
+        out << std::setw(14) << perfEventName(static_cast<PerfEvent>(i));
+      }
+    }
+    out << (hasIpc ? "       IPC" : "") << "\n";
+
+    for(std::size_t p = 0; p < enginePhaseCount; ++p)
+    {
+      const PerfSample &sample = report.phase[p];
+      std::uint64_t any = 0;
+      for(std::uint64_t v : sample.value)
+      {
+        any |= v;
+      }
+      if(any == 0)
+      {
+        continue;
+      }
+
+      out << "  " << std::left << std::setw(16) << enginePhaseName(static_cast<EnginePhase>(p))
+          << std::right;
+      for(std::size_t i = 0; i < perfEventCount; ++i)
+      {
+        if(counted(static_cast<PerfEvent>(i)))
+        {
+          out << std::setw(14) << perBar(sample.value[i], report.bars);
+        }
+      }
+      if(hasIpc)
+      {
+        out << std::setw(10) << std::setprecision(2) << ipc(sample) << std::setprecision(1);
+      }
+      out << "\n";
+    }
+  }
+
+  out.flags(flags);
+  out.precision(precision);
+}
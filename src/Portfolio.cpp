@@ -1,8 +1,40 @@
 #include "Portfolio.hpp"
+#include "Checkpoint.hpp"
+#include "AllocTracker.hpp"
 #include <algorithm>
 #include <cmath>
+#include <stdexcept>
 
-void Portfolio::applyFill(const Fill &f)
+namespace
+{
+
+void writeMoney(CheckpointWriter &out, Money value)
+{
+  if constexpr(fixedPointMoney)
+  {
+    out.writeI64(value);
+  }
+  else
+  {
+    out.writeDouble(value);
+  }
+}
+
+Money readMoney(CheckpointReader &in)
+{
+  if constexpr(fixedPointMoney)
+  {
+    return static_cast<Money>(in.readI64());
+  }
+  else
+  {
+    return static_cast<Money>(in.readDouble());
+  }
+}
+
+} // namespace
+
+double Portfolio::applyFill(const Fill &f)
 {
   int dir = 0;
   switch(f.side)
@@ -19,11 +51,8 @@ void Portfolio::applyFill(const Fill &f)
 
   int signedQty = dir * f.quantity;
 
-  auto &pos = positions_[f.symbol];
-  if(pos.symbol.empty())
-  {
-    pos.symbol = f.symbol;
-  }
+  Position &pos = positionFor(f.symbol);
+  Money realized{};
 
   if(pos.quantity == 0)
   {
@@ -34,26 +63,41 @@ void Portfolio::applyFill(const Fill &f)
   {
     if((pos.quantity > 0 && signedQty > 0) || (pos.quantity < 0 && signedQty < 0))
     {
-      double oldValue = pos.avgPrice * std::abs(pos.quantity);
-      double newValue = f.price * std::abs(signedQty);
+      Money oldValue = pos.avgPrice * std::abs(pos.quantity);
+      Money newValue = f.price * std::abs(signedQty);
       int newQty = pos.quantity + signedQty;
       if(newQty != 0)
       {
-        pos.avgPrice = (oldValue + newValue) / std::abs(newQty);
+        // The only rounding step in fixed-point builds (to the nearest
+        // micro-unit); cash and realized PnL stay exact.
+        pos.avgPrice = divideMoney(oldValue + newValue, std::abs(newQty));
       }
       pos.quantity = newQty;
     }
     else
     {
-      pos.quantity += signedQty;
-      if(pos.quantity == 0)
+      // Reducing or flipping: the closed part realizes PnL against the
+      // average entry price, any remainder opens at the fill price.
+      int closedQty = std::min(std::abs(pos.quantity), std::abs(signedQty));
+      int sign = pos.quantity > 0 ? 1 : -1;
+      realized = (f.price - pos.avgPrice) * closedQty * sign;
+      pos.realizedPnL += realized;
+      realizedPnL_ += realized;
+
+      int newQty = pos.quantity + signedQty;
+      if(newQty == 0)
+      {
+        pos.avgPrice = Money{};
+      }
+      else if((newQty > 0) != (pos.quantity > 0))
       {
-        pos.avgPrice = 0.0;
+        pos.avgPrice = f.price;
       }
+      pos.quantity = newQty;
     }
   }
 
-  double tradeValue = f.price * f.quantity;
+  Money tradeValue = f.price * f.quantity;
   if(dir > 0)
   {
     cash_ -= tradeValue;
@@ -64,41 +108,135 @@ void Portfolio::applyFill(const Fill &f)
     cash_ += tradeValue;
     cash_ -= f.fees;
   }
+
+  return fromMoney(realized);
 }
 
 void Portfolio::markToMarket(const Candle &bar)
 {
-  auto it = positions_.find(bar.symbol);
-  if(it != positions_.end())
+  auto it = index_.find(bar.symbol);
+  if(it != index_.end())
   {
-    auto &pos = it->second;
+    auto &pos = positions_[it->second];
     if(pos.quantity != 0)
     {
-      pos.unrealizedPnL = (bar.close - pos.avgPrice) * pos.quantity;
+      pos.unrealizedPnL = (toMoney(bar.close) - pos.avgPrice) * pos.quantity;
     }
     else
     {
-      pos.unrealizedPnL = 0.0;
+      pos.unrealizedPnL = Money{};
     }
   }
 }
 
-double Portfolio::getEquity() const
+void Portfolio::bindUniverse(const std::vector<std::string> &symbols)
+{
+  for(std::size_t i = 0; i < symbols.size(); ++i)
+  {
+    positionFor(symbols[i]);
+    if(index_.at(symbols[i]) != i)
+    {
+      throw std::logic_error("Portfolio::bindUniverse: positions already exist for "
+                             "a different symbol order");
+    }
+  }
+}
+
+void Portfolio::markToMarket(const double *close,
+                             const std::uint8_t *valid,
+                             std::size_t n)
+{
+  const std::size_t count = std::min(n, positions_.size());
+  Position *pos = positions_.data();
+  for(std::size_t i = 0; i < count; ++i)
+  {
+    const Money pnl = (toMoney(close[i]) - pos[i].avgPrice) * pos[i].quantity;
+    pos[i].unrealizedPnL = valid[i] ? pnl : pos[i].unrealizedPnL;
+  }
+}
+
+Portfolio::Valuation Portfolio::valuation() const
 {
-  double unreal = 0.0;
-  for(const auto &[sym, pos] : positions_)
+  // Cash already paid for the open positions, so equity adds back their
+  // cost basis along with the unrealized PnL (i.e. their market value).
+  Money marketValue{};
+  Money unrealized{};
+  for(const auto &pos : positions_)
   {
-    unreal += pos.unrealizedPnL;
+    marketValue += pos.avgPrice * pos.quantity + pos.unrealizedPnL;
+    unrealized += pos.unrealizedPnL;
   }
-  return cash_ + unreal;
+  Valuation v;
+  v.equity = fromMoney(cash_ + marketValue);
+  v.unrealizedPnL = fromMoney(unrealized);
+  return v;
+}
+
+double Portfolio::getEquity() const
+{
+  return valuation().equity;
+}
+
+double Portfolio::getUnrealizedPnL() const
+{
+  return valuation().unrealizedPnL;
 }
 
 const Position *Portfolio::getPosition(const std::string &symbol) const
 {
-  auto it = positions_.find(symbol);
-  if(it != positions_.end())
+  auto it = index_.find(symbol);
+  if(it != index_.end())
   {
-    return &it->second;
+    return &positions_[it->second];
   }
   return nullptr;
 }
+
+Position &Portfolio::positionFor(const std::string &symbol)
+{
+  auto it = index_.find(symbol);
+  if(it != index_.end())
+  {
+    return positions_[it->second];
+  }
+
+  // First sight of a symbol: a one-off registration, not per-bar work.
+  AllocAllowScope allow;
+  index_.emplace(symbol, positions_.size());
+  Position &pos = positions_.emplace_back();
+  pos.symbol = symbol;
+  return pos;
+}
+
+void Portfolio::saveState(CheckpointWriter &out) const
+{
+  writeMoney(out, cash_);
+  writeMoney(out, realizedPnL_);
+  out.writeU64(positions_.size());
+  for(const auto &pos : positions_)
+  {
+    out.writeString(pos.symbol);
+    out.writeI64(pos.quantity);
+    writeMoney(out, pos.avgPrice);
+    writeMoney(out, pos.unrealizedPnL);
+    writeMoney(out, pos.realizedPnL);
+  }
+}
+
+void Portfolio::loadState(CheckpointReader &in)
+{
+  cash_ = readMoney(in);
+  realizedPnL_ = readMoney(in);
+  positions_.clear();
+  index_.clear();
+
+  std::uint64_t count = in.readU64();
+  for(std::uint64_t i = 0; i < count; ++i)
+  {
+    Position &pos = positionFor(in.readString());
+    pos.quantity = static_cast<int>(in.readI64());
+    pos.avgPrice = readMoney(in);
+    pos.unrealizedPnL = readMoney(in);
+    pos.realizedPnL = readMoney(in);
+  }
+}
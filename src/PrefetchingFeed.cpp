@@ -0,0 +1,137 @@
+#include "feed/PrefetchingFeed.hpp"
+#include "Trace.hpp"
+
+#include <stdexcept>
+
+PrefetchingFeed::PrefetchingFeed(std::unique_ptr<DataFeed_I> inner,
+                                 std::size_t blockSize)
+  : inner_(std::move(inner)),
+    blockSize_(blockSize == 0 ? 1 : blockSize)
+{
+  for(auto &block : blocks_)
+  {
+    block.bars.resize(blockSize_);
+    block.sliceEnds.resize(blockSize_);
+    free_.tryPush(&block);
+  }
+
+  worker_ = std::thread([this] { produce(); });
+}
+
+PrefetchingFeed::~PrefetchingFeed()
+{
+  stop_.store(true, std::memory_order_relaxed);
+  if(worker_.joinable())
+  {
+    worker_.join();
+  }
+}
+
+void PrefetchingFeed::produce()
+{
+  Trace::setThreadName("prefetch decode");
+  for(;;)
+  {
+    Block *block = nullptr;
+    while(!free_.tryPop(block))
+    {
+      if(stop_.load(std::memory_order_relaxed))
+      {
+        return;
+      }
+      std::this_thread::yield();
+    }
+
+    block->count = 0;
+    block->last = false;
+    block->error = nullptr;
+    try
+    {
+      TraceScope trace("decode block");
+      // Copy-assign into the recycled candles so their strings reuse
+      // capacity instead of reallocating every block.
+      while(block->count < blockSize_ && inner_->hasNext())
+      {
+        block->bars[block->count] = inner_->next();
+        block->sliceEnds[block->count] = inner_->endOfSlice() ? 1 : 0;
+        ++block->count;
+      }
+      block->last = !inner_->hasNext();
+    }
+    catch(...)
+    {
+      block->error = std::current_exception();
+      block->last = true;
+    }
+
+    while(!filled_.tryPush(block))
+    {
+      std::this_thread::yield();
+    }
+
+    if(block->last)
+    {
+      return;
+    }
+  }
+}
+
+PrefetchingFeed::Block *PrefetchingFeed::waitForFilled() const
+{
+  Block **slot = nullptr;
+  while((slot = filled_.front()) == nullptr)
+  {
+    std::this_thread::yield();
+  }
+  return *slot;
+}
+
+bool PrefetchingFeed::hasNext() const
+{
+  if(current_ != nullptr && pos_ < current_->count)
+  {
+    return true;
+  }
+  if(current_ != nullptr && current_->last)
+  {
+    if(current_->error)
+    {
+      std::rethrow_exception(current_->error);
+    }
+    return false;
+  }
+
+  // Peek at the next filled block without releasing the current one, so
+  // the bar last returned by next() stays valid.
+  const Block *upcoming = waitForFilled();
+  if(upcoming->error)
+  {
+    std::rethrow_exception(upcoming->error);
+  }
+  return upcoming->count > 0;
+}
+
+const Candle &PrefetchingFeed::next()
+{
+  if(current_ == nullptr || pos_ >= current_->count)
+  {
+    if(!hasNext())
+    {
+      throw std::out_of_range("PrefetchingFeed::next called with no more data");
+    }
+
+    if(current_ != nullptr)
+    {
+      free_.tryPush(current_);
+    }
+    filled_.tryPop(current_);
+    pos_ = 0;
+  }
+
+  return current_->bars[pos_++];
+}
+
+bool PrefetchingFeed::endOfSlice() const
+{
+  return current_ == nullptr || pos_ == 0 || current_->sliceEnds[pos_ - 1] != 0;
+}
@@ -0,0 +1,37 @@
+#include "Rebalancer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void Rebalancer::computeTrades(const double *targetWeights,
+                               const double *close,
+                               const std::uint8_t *valid,
+                               const Position *positions,
+                               std::size_t n,
+                               double equity,
+                               std::pmr::vector<Order> &out) const
+{
+  const double lot = static_cast<double>(std::max(settings_.lotSize, 1));
+
+  for(std::size_t i = 0; i < n; ++i)
+  {
+    const double price = close[i];
+    if(!valid[i] || !(price > 0.0))
+    {
+      continue;
+    }
+
+    const double targetShares = targetWeights[i] * equity / price;
+    const int target = static_cast<int>(std::trunc(targetShares / lot) * lot);
+    const int delta = target - positions[i].quantity;
+    if(delta == 0 || std::abs(delta) * price < settings_.minTradeValue)
+    {
+      continue;
+    }
+
+    Order &o = out.emplace_back();
+    o.symbol = positions[i].symbol;
+    o.side = delta > 0 ? OrderSide::Buy : OrderSide::Sell;
+    o.quantity = std::abs(delta);
+  }
+}
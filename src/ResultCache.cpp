@@ -0,0 +1,217 @@
+#include "ResultCache.hpp"
+#include "FileUtil.hpp"
+#include "Hash.hpp"
+#include "Trace.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+using nlohmann::json;
+
+namespace
+{
+
+std::string toHex(std::uint64_t v)
+{
+  char buf[17];
+  std::snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(v));
+  return buf;
+}
+
+} // namespace
+
+std::uint64_t hashCandles(const std::vector<Candle> &candles)
+{
+  Hasher64 h;
+  h.addU64(candles.size());
+
+  // Column by column, matching how the data is consumed downstream.
+  for(const auto &c : candles)
+  {
+    h.addString(c.timestamp);
+  }
+  for(const auto &c : candles)
+  {
+    h.addString(c.symbol);
+  }
+  for(const auto &c : candles)
+  {
+    h.addDouble(c.open);
+  }
+  for(const auto &c : candles)
+  {
+    h.addDouble(c.high);
+  }
+  for(const auto &c : candles)
+  {
+    h.addDouble(c.low);
+  }
+  for(const auto &c : candles)
+  {
+    h.addDouble(c.close);
+  }
+  for(const auto &c : candles)
+  {
+    h.addDouble(c.volume);
+  }
+
+  return h.digest();
+}
+
+std::uint64_t hashCandles(const std::vector<std::vector<Candle>> &series)
+{
+  std::vector<std::uint64_t> hashes;
+  hashes.reserve(series.size());
+  for(const auto &s : series)
+  {
+    hashes.push_back(hashCandles(s));
+  }
+  return combineSeriesHashes(hashes);
+}
+
+std::uint64_t combineSeriesHashes(const std::vector<std::uint64_t> &hashes)
+{
+  Hasher64 h;
+  h.addU64(hashes.size());
+  for(std::uint64_t v : hashes)
+  {
+    h.addU64(v);
+  }
+  return h.digest();
+}
+
+std::uint64_t codeVersionHash()
+{
+  static const std::uint64_t version = []
+  {
+    Hasher64 h;
+    std::ifstream exe("/proc/self/exe", std::ios::binary);
+    if(exe)
+    {
+      std::string bytes((std::istreambuf_iterator<char>(exe)),
+                        std::istreambuf_iterator<char>());
+      h.addString(bytes);
+    }
+    else
+    {
+      h.addString(__DATE__ " " __TIME__);
+    }
+    return h.digest();
+  }();
+  return version;
+}
+
+ResultCache::ResultCache(std::string directory)
+  : directory_(std::move(directory))
+{
+  std::filesystem::create_directories(directory_);
+}
+
+json reportToJson(const Report &report)
+{
+  return {
+    { "total_return", report.totalReturn },
+    { "max_drawdown", report.maxDrawdown },
+    { "sharpe", report.sharpe },
+    { "cagr", report.cagr },
+    { "realized_pnl", report.realizedPnL },
+    { "unrealized_pnl", report.unrealizedPnL }
+  };
+}
+
+Report reportFromJson(const json &j)
+{
+  Report report;
+  report.totalReturn = j.at("total_return").get<double>();
+  report.maxDrawdown = j.at("max_drawdown").get<double>();
+  report.sharpe = j.at("sharpe").get<double>();
+  report.cagr = j.at("cagr").get<double>();
+  report.realizedPnL = j.at("realized_pnl").get<double>();
+  report.unrealizedPnL = j.at("unrealized_pnl").get<double>();
+  return report;
+}
+
+std::string ResultCache::makeKey(std::uint64_t datasetHash,
+                                 const json &runConfig)
+{
+  Hasher64 h;
+  h.addU64(datasetHash);
+  // nlohmann::json objects keep their keys sorted, so dump() is canonical.
+  h.addString(runConfig.dump());
+  h.addU64(codeVersionHash());
+  return toHex(h.digest());
+}
+
+std::string ResultCache::pathFor(const std::string &key) const
+{
+  return (std::filesystem::path(directory_) / (key + ".json")).string();
+}
+
+std::optional<CachedResult> ResultCache::lookup(const std::string &key) const
+{
+  std::ifstream in(pathFor(key));
+  if(!in)
+  {
+    return std::nullopt;
+  }
+
+  try
+  {
+    json j;
+    in >> j;
+
+    CachedResult result;
+    result.report = reportFromJson(j.at("report"));
+    result.finalEquity = j.at("final_equity").get<double>();
+
+    for(const auto &row : j.at("equity_curve"))
+    {
+      Snapshot s;
+      s.timestamp = row.at(0).get<std::string>();
+      s.equity = row.at(1).get<double>();
+      s.cash = row.at(2).get<double>();
+      s.realizedPnL = row.at(3).get<double>();
+      s.unrealizedPnL = row.at(4).get<double>();
+      result.equityCurve.push_back(s);
+    }
+    return result;
+  }
+  catch(const std::exception &)
+  {
+    // A truncated or foreign file is treated as a miss and overwritten.
+    return std::nullopt;
+  }
+}
+
+void ResultCache::store(const std::string &key, const CachedResult &result) const
+{
+  TraceScope trace("write result cache");
+  json j;
+  j["report"] = reportToJson(result.report);
+  j["final_equity"] = result.finalEquity;
+
+  json curve = json::array();
+  for(const auto &s : result.equityCurve)
+  {
+    curve.push_back({ s.timestamp, s.equity, s.cash, s.realizedPnL, s.unrealizedPnL });
+  }
+  j["equity_curve"] = std::move(curve);
+
+  // Write-then-rename so concurrent jobs never observe a partial entry.
+  std::string path = pathFor(key);
+  std::string tmp = uniqueTempPath(path);
+  {
+    std::ofstream out(tmp, std::ios::trunc);
+    out << j.dump();
+    out.close();
+    if(!out)
+    {
+      std::filesystem::remove(tmp);
+      throw std::runtime_error("Failed to write result cache entry: " + tmp);
+    }
+  }
+  std::filesystem::rename(tmp, path);
+}
@@ -0,0 +1,49 @@
+#include "RunArena.hpp"
+
+#include <algorithm>
+
+RunArena::RunArena(std::size_t initialBytes, std::size_t maxBufferBytes)
+  : buffer_(new std::byte[initialBytes]),
+    bufferBytes_(initialBytes),
+    maxBufferBytes_(std::max(initialBytes, maxBufferBytes))
+{
+  rebuild();
+}
+
+void RunArena::reset()
+{
+  pool_.reset();
+  monotonic_.reset();
+
+  const std::size_t wanted = std::min(bufferBytes_ + overflow_.total, maxBufferBytes_);
+  if(wanted > bufferBytes_)
+  {
+    bufferBytes_ = wanted;
+    buffer_.reset(new std::byte[bufferBytes_]);
+  }
+  overflow_.total = 0;
+
+  rebuild();
+}
+
+void RunArena::rebuild()
+{
+  monotonic_.emplace(buffer_.get(), bufferBytes_, &overflow_);
+  pool_.emplace(&*monotonic_);
+}
+
+void *RunArena::OverflowResource::do_allocate(std::size_t n, std::size_t alignment)
+{
+  total += n;
+  return std::pmr::new_delete_resource()->allocate(n, alignment);
+}
+
+void RunArena::OverflowResource::do_deallocate(void *p, std::size_t n, std::size_t alignment)
+{
+  std::pmr::new_delete_resource()->deallocate(p, n, alignment);
+}
+
+bool RunArena::OverflowResource::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+  return this == &other;
+}
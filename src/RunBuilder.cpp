@@ -0,0 +1,287 @@
+#include "RunBuilder.hpp"
+#include "CandleStore.hpp"
+#include "ColumnarStore.hpp"
+#include "MultiSymbolStrategy.hpp"
+#include "StrategyFactory.hpp"
+#include "SweepRunner.hpp"
+#include "feed/AlphaVantageFeed.hpp"
+#include "feed/CandleViewFeed.hpp"
+#include "feed/MergedFeed.hpp"
+#include "feed/PrefetchingFeed.hpp"
+#include "feed/SharedDatasetFeed.hpp"
+#include "feed/UniverseFeed.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+
+using nlohmann::json;
+
+namespace
+{
+
+// The series a merged feed takes over: the owned ones, or copies of the
+// resident ones.
+std::vector<std::vector<Candle>> takeSeries(RunData &data)
+{
+  if(data.resident.empty())
+  {
+    return std::move(data.series);
+  }
+  std::vector<std::vector<Candle>> copies;
+  copies.reserve(data.resident.size());
+  for(const auto &candles : data.resident)
+  {
+    copies.push_back(*candles);
+  }
+  return copies;
+}
+
+} // namespace
+
+std::vector<std::string> configSymbols(const json &cfg)
+{
+  std::vector<std::string> symbols;
+  if(cfg.contains("assets"))
+  {
+    symbols = cfg.at("assets").get<std::vector<std::string>>();
+  }
+  else
+  {
+    symbols.push_back(cfg.at("asset").get<std::string>());
+  }
+  if(symbols.empty())
+  {
+    throw std::runtime_error("Config lists no assets");
+  }
+  return symbols;
+}
+
+TimeRange dataRange(const json &dataCfg)
+{
+  return parseTimeRange(dataCfg.value("start", std::string{}),
+                        dataCfg.value("end", std::string{}));
+}
+
+BarFields runBarFields(const std::string &mode,
+                       const std::vector<std::string> &symbols,
+                       const json &stratCfg)
+{
+  BarFields fields = BarField::Close;
+  if(mode == "cross_sectional")
+  {
+    fields |= createCrossSectionalStrategy(symbols, stratCfg)->barFields();
+  }
+  else
+  {
+    json probeCfg = mode == "sweep" ? SweepRunner::expandGrid(stratCfg).front() : stratCfg;
+    fields |= createStrategy(symbols.front(), probeCfg)->barFields();
+  }
+  return fields;
+}
+
+std::vector<std::vector<Candle>> fetchSeries(const json &dataCfg,
+                                             const std::vector<std::string> &symbols,
+                                             BarFields fields)
+{
+  std::string provider = dataCfg.at("provider").get<std::string>();
+  std::string interval = dataCfg.at("interval").get<std::string>();
+  int lookbackBars = dataCfg.at("lookback_bars").get<int>();
+  const TimeRange range = dataRange(dataCfg);
+
+  std::vector<std::vector<Candle>> series;
+
+  if(provider == "alpha_vantage")
+  {
+    if(interval != "daily")
+    {
+      std::cerr << "WARNING: only 'daily' supported; got '"
+                << interval << "'. Using daily.\n";
+    }
+
+    const char *keyEnv = std::getenv("ALPHAVANTAGE_API_KEY");
+    if(!keyEnv)
+    {
+      throw std::runtime_error("ALPHAVANTAGE_API_KEY is not set");
+    }
+    std::string apiKey = keyEnv;
+
+    // Every symbol is requested concurrently, within the provider's rate
+    // limit; "base_url" can point at a local stand-in server.
+    AlphaVantageOptions options;
+    options.baseUrl = dataCfg.value("base_url", options.baseUrl);
+    options.http.concurrency = dataCfg.value("concurrency", options.http.concurrency);
+    options.http.requestsPerMinute =
+      dataCfg.value("requests_per_minute", options.http.requestsPerMinute);
+    options.outputSize = dataCfg.value("output_size", options.outputSize);
+
+    // With a local store only the bars missing from it are downloaded.
+    std::string storeDir = dataCfg.value("store", std::string{});
+    if(storeDir.empty() && !range.bounded())
+    {
+      series = fetchAlphaVantageSeries(apiKey, symbols, lookbackBars, options);
+    }
+    else if(storeDir.empty())
+    {
+      // A compact response holds only the latest 100 bars, which may miss
+      // the range entirely: fetch the full history and cut it to the range.
+      options.outputSize = "full";
+      series = fetchAlphaVantageSeries(apiKey, symbols, 0, options);
+      for(auto &candles : series)
+      {
+        std::vector<std::int64_t> times;
+        times.reserve(candles.size());
+        for(const Candle &c : candles)
+        {
+          times.push_back(parseTimestamp(c.timestamp));
+        }
+        auto [first, last] = selectRows(times.data(), times.size(), range, lookbackBars);
+        candles.erase(candles.begin() + static_cast<std::ptrdiff_t>(last), candles.end());
+        candles.erase(candles.begin(), candles.begin() + static_cast<std::ptrdiff_t>(first));
+      }
+    }
+    else
+    {
+      CandleStore store(storeDir);
+      updateAlphaVantageStore(store, apiKey, symbols, options);
+      for(const auto &symbol : symbols)
+      {
+        series.push_back(store.load(symbol, lookbackBars, range));
+      }
+    }
+  }
+  else if(provider == "columnar")
+  {
+    // A dataset written by backtest_import. The range and the projection
+    // are pushed down to the shards, which read only the chunks overlapping
+    // the range and only the columns the run needs.
+    ColumnarDataset dataset(dataCfg.at("path").get<std::string>());
+    for(const auto &symbol : symbols)
+    {
+      series.push_back(dataset.load(symbol, lookbackBars, range, fields));
+    }
+  }
+  else
+  {
+    throw std::runtime_error("Unsupported data provider: " + provider);
+  }
+
+  return series;
+}
+
+RunData loadRunData(const json &dataCfg,
+                    const std::vector<std::string> &symbols,
+                    const std::string &mode,
+                    BarFields fields)
+{
+  RunData data;
+  data.fields = fields;
+  if(dataCfg.at("provider").get<std::string>() != "shared_memory")
+  {
+    data.series = fetchSeries(dataCfg, symbols, fields);
+    return data;
+  }
+
+  data.shared = std::make_shared<const SharedDataset>(dataCfg.at("dataset").get<std::string>());
+  data.sharedLookback = dataCfg.value("lookback_bars", 0);
+  data.sharedRange = dataRange(dataCfg);
+  for(const auto &symbol : symbols)
+  {
+    data.sharedIds.push_back(data.shared->idOf(symbol));
+    if(mode != "per_bar")
+    {
+      data.series.push_back(data.shared->candles(data.sharedIds.back(), data.sharedLookback,
+                                                 data.sharedRange, fields));
+    }
+  }
+  return data;
+}
+
+std::unique_ptr<BacktestEngine>
+buildEngine(const json &cfg, RunData &data, std::pmr::memory_resource *resource)
+{
+  const std::vector<std::string> symbols = configSymbols(cfg);
+  const double initialCash = cfg.at("initial_cash").get<double>();
+  const json &stratCfg = cfg.at("strategy");
+  const json engineCfg = cfg.value("engine", json::object());
+  const json dataCfg = cfg.value("data", json::object());
+  const std::string mode = engineCfg.value("mode", std::string{ "per_bar" });
+
+  auto exec = createExecutionEngine(engineCfg);
+  std::unique_ptr<BacktestEngine> engine;
+
+  if(mode == "cross_sectional")
+  {
+    engine = std::make_unique<BacktestEngine>(
+      createCrossSectionalStrategy(symbols, stratCfg, resource),
+      std::move(exec),
+      std::make_unique<UniverseFeed>(std::make_unique<MergedFeed>(takeSeries(data))),
+      initialCash,
+      resource);
+
+    RebalanceSettings rebalance;
+    rebalance.lotSize = engineCfg.value("lot_size", 1);
+    rebalance.minTradeValue = engineCfg.value("min_trade_value", 0.0);
+    engine->setRebalanceSettings(rebalance);
+  }
+  else if(mode == "per_bar")
+  {
+    // Let the factory decide which concrete strategy to build; with several
+    // assets each symbol gets its own instance over one merged feed.
+    std::unique_ptr<Strategy_I> strategy;
+    std::unique_ptr<DataFeed_I> feed;
+    if(data.shared)
+    {
+      feed = std::make_unique<SharedDatasetFeed>(data.shared, data.sharedIds,
+                                                 data.sharedLookback, data.sharedRange,
+                                                 data.fields);
+    }
+    if(symbols.size() == 1)
+    {
+      strategy = createStrategy(symbols.front(), stratCfg, resource);
+      if(!feed && !data.resident.empty())
+      {
+        feed = std::make_unique<CandleViewFeed>(*data.resident.front());
+      }
+      else if(!feed)
+      {
+        feed = std::make_unique<AlphaVantageFeed>(std::move(data.series.front()));
+      }
+    }
+    else
+    {
+      auto multi = std::make_unique<MultiSymbolStrategy>();
+      for(const auto &symbol : symbols)
+      {
+        multi->add(symbol, createStrategy(symbol, stratCfg, resource));
+      }
+      strategy = std::move(multi);
+      if(!feed)
+      {
+        feed = std::make_unique<MergedFeed>(takeSeries(data));
+      }
+    }
+
+    // Optional background decode: overlap feed I/O with strategy compute.
+    int prefetchBars = dataCfg.value("prefetch_bars", 0);
+    if(prefetchBars > 0)
+    {
+      feed = std::make_unique<PrefetchingFeed>(std::move(feed),
+                                               static_cast<std::size_t>(prefetchBars));
+    }
+
+    engine = std::make_unique<BacktestEngine>(std::move(strategy),
+                                              std::move(exec),
+                                              std::move(feed),
+                                              initialCash,
+                                              resource);
+  }
+  else
+  {
+    throw std::runtime_error("Unsupported engine mode: " + mode);
+  }
+
+  engine->setPipelined(engineCfg.value("pipelined", false));
+  return engine;
+}
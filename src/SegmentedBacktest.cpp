@@ -0,0 +1,205 @@
+#include "SegmentedBacktest.hpp"
+#include "BacktestEngine.hpp"
+#include "Log.hpp"
+#include "Metrics.hpp"
+#include "Trace.hpp"
+#include "feed/AlphaVantageFeed.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+
+SegmentedResult finish(std::vector<Snapshot> curve)
+{
+  Metrics metrics;
+  for(const auto &s : curve)
+  {
+    metrics.record(s);
+  }
+
+  SegmentedResult result;
+  result.report = metrics.computeReport();
+  result.finalEquity = curve.empty() ? 0.0 : curve.back().equity;
+  result.equityCurve = std::move(curve);
+  return result;
+}
+
+} // namespace
+
+SegmentedBacktest::SegmentedBacktest(std::vector<Candle> candles,
+                                     StrategyMaker makeStrategy,
+                                     ExecutionMaker makeExecution,
+                                     double initialCash,
+                                     std::size_t segments)
+  : candles_(std::move(candles)),
+    makeStrategy_(std::move(makeStrategy)),
+    makeExecution_(std::move(makeExecution)),
+    initialCash_(initialCash)
+{
+  warmup_ = makeStrategy_()->warmupBars();
+  if(warmup_ == Strategy_I::unboundedWarmup)
+  {
+    throw std::invalid_argument("Segmented backtests need a strategy with a bounded warmup");
+  }
+
+  const std::size_t n = candles_.size();
+  const std::size_t k = std::max<std::size_t>(1, std::min(segments, n));
+  for(std::size_t i = 0; i <= k; ++i)
+  {
+    bounds_.push_back(n * i / k);
+  }
+}
+
+SegmentedBacktest::SegmentRun SegmentedBacktest::runSegment(std::size_t k) const
+{
+  const std::size_t begin = bounds_[k];
+  const std::size_t end = bounds_[k + 1];
+  const std::size_t warmStart = begin > warmup_ ? begin - warmup_ : 0;
+
+  using Diff = std::vector<Candle>::difference_type;
+  std::vector<Candle> slice(candles_.begin() + static_cast<Diff>(warmStart),
+                            candles_.begin() + static_cast<Diff>(end));
+
+  BacktestEngine engine(makeStrategy_(),
+                        makeExecution_(),
+                        std::make_unique<AlphaVantageFeed>(std::move(slice)),
+                        initialCash_);
+  engine.setWarmup(begin - warmStart);
+  engine.setFlattenPoints({ end - warmStart - 1 });
+  engine.run();
+
+  const auto &curve = engine.metrics().snapshots();
+  return { { curve.begin(), curve.end() } };
+}
+
+SegmentedResult SegmentedBacktest::runParallel(std::size_t threads) const
+{
+  const std::size_t k = segmentCount();
+  if(threads == 0)
+  {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  threads = std::min(threads, k);
+
+  std::vector<SegmentRun> runs(k);
+  std::vector<std::exception_ptr> errors(k);
+  std::atomic<std::size_t> nextSegment{ 0 };
+
+  auto worker = [&](std::size_t w)
+  {
+    if(Trace::enabled())
+    {
+      Trace::setThreadName("segment worker " + std::to_string(w));
+    }
+
+    for(std::size_t s = nextSegment++; s < k; s = nextSegment++)
+    {
+      TraceScope trace("segment", static_cast<std::int64_t>(s));
+      LogContext context("segment", static_cast<std::int64_t>(s));
+      try
+      {
+        runs[s] = runSegment(s);
+      }
+      catch(...)
+      {
+        errors[s] = std::current_exception();
+      }
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for(std::size_t t = 1; t < threads; ++t)
+  {
+    pool.emplace_back(worker, t);
+  }
+  worker(0);
+  for(auto &t : pool)
+  {
+    t.join();
+  }
+
+  for(const auto &e : errors)
+  {
+    if(e)
+    {
+      std::rethrow_exception(e);
+    }
+  }
+
+  // Stitch: every segment starts from initialCash_ and ends flat, so its
+  // equity relative to initialCash_ is pure PnL that chains onto the
+  // previous segment's closing equity.
+  std::vector<Snapshot> curve;
+  curve.reserve(candles_.size());
+  double offset = 0.0;
+  double realizedOffset = 0.0;
+  for(auto &run : runs)
+  {
+    for(auto s : run.curve)
+    {
+      s.equity += offset;
+      s.cash += offset;
+      s.realizedPnL += realizedOffset;
+      curve.push_back(std::move(s));
+    }
+    if(!curve.empty())
+    {
+      offset = curve.back().equity - initialCash_;
+      realizedOffset = curve.back().realizedPnL;
+    }
+  }
+
+  return finish(std::move(curve));
+}
+
+SegmentedResult SegmentedBacktest::runSerial() const
+{
+  std::vector<std::size_t> flattenPoints;
+  for(std::size_t k = 1; k < bounds_.size(); ++k)
+  {
+    flattenPoints.push_back(bounds_[k] - 1);
+  }
+
+  BacktestEngine engine(makeStrategy_(),
+                        makeExecution_(),
+                        std::make_unique<AlphaVantageFeed>(candles_),
+                        initialCash_);
+  engine.setFlattenPoints(std::move(flattenPoints));
+  engine.run();
+
+  const auto &curve = engine.metrics().snapshots();
+  return finish({ curve.begin(), curve.end() });
+}
+
+bool SegmentedBacktest::equivalent(const SegmentedResult &a,
+                                   const SegmentedResult &b,
+                                   double relTolerance)
+{
+  auto close = [relTolerance](double x, double y)
+  {
+    return std::abs(x - y) <= relTolerance * std::max({ 1.0, std::abs(x), std::abs(y) });
+  };
+
+  if(a.equityCurve.size() != b.equityCurve.size())
+  {
+    return false;
+  }
+  for(std::size_t i = 0; i < a.equityCurve.size(); ++i)
+  {
+    if(a.equityCurve[i].timestamp != b.equityCurve[i].timestamp
+       || !close(a.equityCurve[i].equity, b.equityCurve[i].equity))
+    {
+      return false;
+    }
+  }
+
+  return close(a.report.totalReturn, b.report.totalReturn)
+         && close(a.report.maxDrawdown, b.report.maxDrawdown)
+         && close(a.report.sharpe, b.report.sharpe)
+         && close(a.report.cagr, b.report.cagr);
+}
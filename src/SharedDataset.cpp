@@ -0,0 +1,353 @@
+#include "SharedDataset.hpp"
+#include "ResultCache.hpp"
+#include "Timestamp.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <set>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+
+constexpr char datasetMagic[8] = { 'B', 'T', 'S', 'H', 'M', 'D', 'S', '\0' };
+constexpr std::uint32_t datasetVersion = 1;
+constexpr std::size_t columnCount = 6; // time, open, high, low, close, volume
+constexpr std::size_t columnAlignment = 64;
+constexpr std::size_t maxSymbolLength = 31;
+
+// Published last: `ready` turns 1 once every other byte is in place, so a
+// process attaching mid-publication sees 0 (the object starts zeroed).
+struct Header
+{
+  char magic[8];
+  std::atomic<std::uint32_t> ready;
+  std::uint32_t version;
+  std::uint64_t symbolCount;
+  std::uint64_t rowCount;
+  std::uint64_t bytes;
+  std::uint64_t columnOffset[columnCount];
+};
+
+struct ManifestEntry
+{
+  char symbol[maxSymbolLength + 1];
+  std::uint64_t firstRow;
+  std::uint64_t rowCount;
+  std::uint64_t hash;
+};
+
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free,
+              "the ready flag is shared between processes");
+
+std::runtime_error systemError(const std::string &what)
+{
+  return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+std::string objectName(const std::string &name)
+{
+  if(name.empty() || name.find('/') != std::string::npos)
+  {
+    throw std::runtime_error("Invalid shared dataset name: '" + name + "'");
+  }
+  return "/backtest." + name;
+}
+
+std::size_t alignUp(std::size_t n)
+{
+  return (n + columnAlignment - 1) / columnAlignment * columnAlignment;
+}
+
+class FileDescriptor
+{
+public:
+  explicit FileDescriptor(int fd)
+    : fd_(fd) {}
+  ~FileDescriptor()
+  {
+    if(fd_ >= 0)
+    {
+      ::close(fd_);
+    }
+  }
+
+  FileDescriptor(const FileDescriptor &) = delete;
+  FileDescriptor &operator=(const FileDescriptor &) = delete;
+
+  int get() const { return fd_; }
+
+private:
+  int fd_;
+};
+
+} // namespace
+
+SharedDataset::SharedDataset(const std::string &name)
+  : name_(name)
+{
+  const std::string object = objectName(name);
+  FileDescriptor fd(::shm_open(object.c_str(), O_RDONLY, 0));
+  if(fd.get() < 0)
+  {
+    throw systemError("Cannot open shared dataset '" + name + "'");
+  }
+
+  struct stat st{};
+  if(::fstat(fd.get(), &st) != 0)
+  {
+    throw systemError("Cannot stat shared dataset '" + name + "'");
+  }
+  bytes_ = static_cast<std::size_t>(st.st_size);
+  if(bytes_ < sizeof(Header))
+  {
+    throw std::runtime_error("Shared dataset '" + name + "' is still being published");
+  }
+
+  void *base = ::mmap(nullptr, bytes_, PROT_READ, MAP_SHARED, fd.get(), 0);
+  if(base == MAP_FAILED)
+  {
+    throw systemError("Cannot map shared dataset '" + name + "'");
+  }
+  base_ = base;
+
+  try
+  {
+    const auto *bytes = static_cast<const unsigned char *>(base);
+    const auto &header = *reinterpret_cast<const Header *>(bytes);
+    if(std::memcmp(header.magic, datasetMagic, sizeof(datasetMagic)) != 0)
+    {
+      throw std::runtime_error("'" + name + "' is not a shared dataset");
+    }
+    if(header.ready.load(std::memory_order_acquire) == 0)
+    {
+      throw std::runtime_error("Shared dataset '" + name + "' is still being published");
+    }
+    if(header.version != datasetVersion)
+    {
+      throw std::runtime_error("Shared dataset '" + name + "' has unsupported version "
+                               + std::to_string(header.version));
+    }
+
+    const std::size_t rows = header.rowCount;
+    const std::size_t manifestEnd = sizeof(Header) + header.symbolCount * sizeof(ManifestEntry);
+    bool fits = header.bytes == bytes_ && manifestEnd <= bytes_;
+    for(std::uint64_t offset : header.columnOffset)
+    {
+      fits = fits && offset >= manifestEnd && offset <= bytes_
+             && rows <= (bytes_ - offset) / sizeof(double);
+    }
+    if(!fits)
+    {
+      throw std::runtime_error("Shared dataset '" + name + "' is truncated");
+    }
+
+    const auto *manifest = reinterpret_cast<const ManifestEntry *>(bytes + sizeof(Header));
+    auto column = [&](std::size_t c, std::size_t row)
+    { return reinterpret_cast<const double *>(bytes + header.columnOffset[c]) + row; };
+
+    series_.reserve(header.symbolCount);
+    for(std::size_t s = 0; s < header.symbolCount; ++s)
+    {
+      const ManifestEntry &e = manifest[s];
+      if(e.firstRow > rows || e.rowCount > rows - e.firstRow)
+      {
+        throw std::runtime_error("Shared dataset '" + name + "' has a corrupt manifest");
+      }
+      const std::size_t row = e.firstRow;
+      series_.push_back({ std::string(e.symbol, ::strnlen(e.symbol, sizeof(e.symbol))),
+                          reinterpret_cast<const std::int64_t *>(bytes + header.columnOffset[0])
+                            + row,
+                          column(1, row), column(2, row), column(3, row), column(4, row),
+                          column(5, row), e.rowCount, e.hash });
+    }
+  }
+  catch(...)
+  {
+    ::munmap(base, bytes_);
+    throw;
+  }
+}
+
+SharedDataset::~SharedDataset()
+{
+  ::munmap(const_cast<void *>(base_), bytes_);
+}
+
+std::size_t SharedDataset::idOf(const std::string &symbol) const
+{
+  for(std::size_t id = 0; id < series_.size(); ++id)
+  {
+    if(series_[id].symbol == symbol)
+    {
+      return id;
+    }
+  }
+  throw std::runtime_error("Shared dataset '" + name_ + "' has no symbol " + symbol);
+}
+
+std::vector<Candle> SharedDataset::candles(std::size_t id, int lookbackBars,
+                                           const TimeRange &range, BarFields fields) const
+{
+  const Series &s = series_.at(id);
+  const auto [first, last] = selectRows(s.time, s.size, range, lookbackBars);
+
+  auto at = [fields](const double *column, BarFields field, std::size_t i)
+  { return fields & field ? column[i] : 0.0; };
+
+  std::vector<Candle> out;
+  out.reserve(last - first);
+  for(std::size_t i = first; i < last; ++i)
+  {
+    out.push_back({ formatTimestamp(s.time[i]), s.symbol, at(s.open, BarField::Open, i),
+                    at(s.high, BarField::High, i), at(s.low, BarField::Low, i),
+                    at(s.close, BarField::Close, i), at(s.volume, BarField::Volume, i) });
+  }
+  return out;
+}
+
+std::size_t publishSharedDataset(const std::string &name,
+                                 const std::vector<std::vector<Candle>> &series)
+{
+  const std::string object = objectName(name);
+
+  // Validate everything before touching the old dataset.
+  std::size_t rows = 0;
+  std::set<std::string> seen;
+  std::vector<std::vector<std::int64_t>> times(series.size());
+  for(std::size_t s = 0; s < series.size(); ++s)
+  {
+    const auto &bars = series[s];
+    const std::string symbol = bars.empty() ? std::string{} : bars.front().symbol;
+    if(symbol.empty() || symbol.size() > maxSymbolLength || !seen.insert(symbol).second)
+    {
+      throw std::runtime_error("Cannot publish series " + std::to_string(s) + " ('" + symbol
+                               + "'): empty, unnamed, duplicate or name too long");
+    }
+
+    times[s].reserve(bars.size());
+    for(const auto &bar : bars)
+    {
+      if(bar.symbol != symbol)
+      {
+        throw std::runtime_error("Series for " + symbol + " also holds " + bar.symbol);
+      }
+      times[s].push_back(parseTimestamp(bar.timestamp));
+      if(times[s].size() > 1 && times[s].back() < times[s][times[s].size() - 2])
+      {
+        throw std::runtime_error("Series for " + symbol + " is not sorted by timestamp");
+      }
+    }
+    rows += bars.size();
+  }
+
+  std::uint64_t columnOffset[columnCount];
+  std::size_t bytes = alignUp(sizeof(Header) + series.size() * sizeof(ManifestEntry));
+  for(std::uint64_t &offset : columnOffset)
+  {
+    offset = bytes;
+    bytes = alignUp(bytes + rows * sizeof(double));
+  }
+
+  // Readers that already attached keep the old object alive.
+  if(::shm_unlink(object.c_str()) != 0 && errno != ENOENT)
+  {
+    throw systemError("Cannot replace shared dataset '" + name + "'");
+  }
+  FileDescriptor fd(::shm_open(object.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644));
+  if(fd.get() < 0)
+  {
+    throw systemError("Cannot create shared dataset '" + name + "'");
+  }
+
+  void *base = MAP_FAILED;
+  try
+  {
+    // Reserve the pages up front: running out of /dev/shm while filling a
+    // sparse object would be a SIGBUS instead of an error.
+    if(int err = ::posix_fallocate(fd.get(), 0, static_cast<off_t>(bytes)); err != 0)
+    {
+      errno = err;
+      throw systemError("Cannot size shared dataset '" + name + "'");
+    }
+    base = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd.get(), 0);
+    if(base == MAP_FAILED)
+    {
+      throw systemError("Cannot map shared dataset '" + name + "'");
+    }
+
+    auto *out = static_cast<unsigned char *>(base);
+    auto *manifest = reinterpret_cast<ManifestEntry *>(out + sizeof(Header));
+    auto *time = reinterpret_cast<std::int64_t *>(out + columnOffset[0]);
+    double *column[columnCount];
+    for(std::size_t c = 1; c < columnCount; ++c)
+    {
+      column[c] = reinterpret_cast<double *>(out + columnOffset[c]);
+    }
+
+    std::size_t row = 0;
+    for(std::size_t s = 0; s < series.size(); ++s)
+    {
+      const auto &bars = series[s];
+      ManifestEntry &e = manifest[s];
+      std::memcpy(e.symbol, bars.front().symbol.c_str(), bars.front().symbol.size() + 1);
+      e.firstRow = row;
+      e.rowCount = bars.size();
+      e.hash = hashCandles(bars);
+
+      std::copy(times[s].begin(), times[s].end(), time + row);
+      for(const auto &bar : bars)
+      {
+        column[1][row] = bar.open;
+        column[2][row] = bar.high;
+        column[3][row] = bar.low;
+        column[4][row] = bar.close;
+        column[5][row] = bar.volume;
+        ++row;
+      }
+    }
+
+    auto *header = new(out) Header{};
+    std::memcpy(header->magic, datasetMagic, sizeof(datasetMagic));
+    header->version = datasetVersion;
+    header->symbolCount = series.size();
+    header->rowCount = rows;
+    header->bytes = bytes;
+    std::copy(std::begin(columnOffset), std::end(columnOffset), header->columnOffset);
+    header->ready.store(1, std::memory_order_release);
+
+    ::munmap(base, bytes);
+  }
+  catch(...)
+  {
+    if(base != MAP_FAILED)
+    {
+      ::munmap(base, bytes);
+    }
+    ::shm_unlink(object.c_str());
+    throw;
+  }
+  return bytes;
+}
+
+bool removeSharedDataset(const std::string &name)
+{
+  const std::string object = objectName(name);
+  if(::shm_unlink(object.c_str()) == 0)
+  {
+    return true;
+  }
+  if(errno == ENOENT)
+  {
+    return false;
+  }
+  throw systemError("Cannot remove shared dataset '" + name + "'");
+}
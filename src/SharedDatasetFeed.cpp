@@ -0,0 +1,104 @@
+#include "feed/SharedDatasetFeed.hpp"
+#include "Timestamp.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+SharedDatasetFeed::SharedDatasetFeed(std::shared_ptr<const SharedDataset> dataset,
+                                     const std::vector<std::size_t> &ids,
+                                     int lookbackBars,
+                                     const TimeRange &range,
+                                     BarFields fields)
+  : dataset_(std::move(dataset)), fields_(fields)
+{
+  cursors_.reserve(ids.size());
+  for(std::size_t id : ids)
+  {
+    const SharedDataset::Series &s = dataset_->series(id);
+    const auto [first, last] = selectRows(s.time, s.size, range, lookbackBars);
+
+    Cursor cursor{ &s, first, last, {} };
+    cursor.bar.symbol = s.symbol;
+    cursors_.push_back(std::move(cursor));
+    if(first < last)
+    {
+      heap_.push_back(static_cast<std::uint32_t>(cursors_.size() - 1));
+    }
+  }
+
+  std::make_heap(heap_.begin(), heap_.end(),
+                 [this](std::uint32_t a, std::uint32_t b) { return later(a, b); });
+}
+
+std::pair<SharedDatasetFeed::Cursor *, std::size_t> SharedDatasetFeed::advance()
+{
+  auto byTime = [this](std::uint32_t a, std::uint32_t b) { return later(a, b); };
+
+  std::pop_heap(heap_.begin(), heap_.end(), byTime);
+  Cursor &cursor = cursors_[heap_.back()];
+  const std::size_t row = cursor.row++;
+  if(cursor.row < cursor.end)
+  {
+    std::push_heap(heap_.begin(), heap_.end(), byTime);
+  }
+  else
+  {
+    heap_.pop_back();
+  }
+
+  endOfSlice_ = heap_.empty() || nextTime(heap_.front()) != cursor.series->time[row];
+  return { &cursor, row };
+}
+
+const Candle &SharedDatasetFeed::next()
+{
+  if(!hasNext())
+  {
+    throw std::out_of_range("SharedDatasetFeed::next called with no more data");
+  }
+
+  auto [cursor, row] = advance();
+  const SharedDataset::Series &s = *cursor->series;
+  Candle &bar = cursor->bar;
+  formatTimestamp(s.time[row], bar.timestamp);
+  // Projection: a close-only strategy touches two of the six columns.
+  if(fields_ & BarField::Open)
+  {
+    bar.open = s.open[row];
+  }
+  if(fields_ & BarField::High)
+  {
+    bar.high = s.high[row];
+  }
+  if(fields_ & BarField::Low)
+  {
+    bar.low = s.low[row];
+  }
+  if(fields_ & BarField::Close)
+  {
+    bar.close = s.close[row];
+  }
+  if(fields_ & BarField::Volume)
+  {
+    bar.volume = s.volume[row];
+  }
+  return bar;
+}
+
+void SharedDatasetFeed::skip(std::size_t count)
+{
+  for(std::size_t i = 0; i < count && hasNext(); ++i)
+  {
+    advance();
+  }
+}
+
+std::size_t SharedDatasetFeed::remaining() const
+{
+  std::size_t n = 0;
+  for(const Cursor &c : cursors_)
+  {
+    n += c.end - c.row;
+  }
+  return n;
+}
@@ -12,8 +12,18 @@ SimpleExecutionEngine::execute(const Order &order, const Candle &bar)
   f.symbol = order.symbol;
   f.quantity = order.quantity;
   f.side = order.side;
-  f.price = bar.close;
-  f.fees = 0.0;
+  f.price = toMoney(roundToTick(bar.close, tickSize(order.symbol)));
+  f.fees = Money{};
   f.timestamp = bar.timestamp;
   return f;
 }
+
+double SimpleExecutionEngine::tickSize(const std::string &symbol) const
+{
+  if(ticks_.empty())
+  {
+    return defaultTick_;
+  }
+  auto it = ticks_.find(symbol);
+  return it != ticks_.end() ? it->second : defaultTick_;
+}
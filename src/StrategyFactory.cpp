@@ -1,5 +1,6 @@
 #include "StrategyFactory.hpp"
 #include "Strategy_I.hpp"
+#include <cstdint>
 #include <stdexcept>
 
 // Forward declarations of concrete strategy factories
@@ -8,7 +9,8 @@ makeTrendRsiStrategy(const std::string &symbol,
                      int period,
                      double overbought,
                      double oversold,
-                     int trendWindow);
+                     int trendWindow,
+                     std::pmr::memory_resource *resource);
 
 // create new strategy demo
 /*
@@ -21,22 +23,32 @@ makeMyNewStrategy(const std::string &symbol,
 std::unique_ptr<Strategy_I>
 makeSmaCrossoverStrategy(const std::string &symbol,
                          int shortPeriod,
-                         int longPeriod);
+                         int longPeriod,
+                         std::pmr::memory_resource *resource);
 
 std::unique_ptr<Strategy_I>
 makeBreakoutStrategy(const std::string &symbol,
-                     std::size_t lookbackWindow);
+                     std::size_t lookbackWindow,
+                     std::pmr::memory_resource *resource);
 
 std::unique_ptr<Strategy_I>
 makeZScoreMeanReversionStrategy(const std::string &symbol,
                                 int lookback,
                                 double entryZ,
-                                double exitZ);
+                                double exitZ,
+                                std::pmr::memory_resource *resource);
+
+std::unique_ptr<CrossSectionalStrategy_I>
+makeMomentumRankStrategy(std::size_t universeSize,
+                         std::size_t lookback,
+                         std::size_t topN,
+                         std::pmr::memory_resource *resource);
 
 // register strategy names for config.json
 std::unique_ptr<Strategy_I>
 createStrategy(const std::string &symbol,
-               const nlohmann::json &stratCfg)
+               const nlohmann::json &stratCfg,
+               std::pmr::memory_resource *resource)
 {
   std::string stratName = stratCfg.at("name").get<std::string>();
   const auto &params = stratCfg.at("params");
@@ -48,7 +60,7 @@ createStrategy(const std::string &symbol,
     double oversold = params.at("oversold").get<double>();
     int trendWindow = params.at("trend_window").get<int>();
 
-    return makeTrendRsiStrategy(symbol, period, overbought, oversold, trendWindow);
+    return makeTrendRsiStrategy(symbol, period, overbought, oversold, trendWindow, resource);
   }
   // register strategy name demo
   /*
@@ -65,12 +77,12 @@ createStrategy(const std::string &symbol,
     int shortP = params.at("short_period").get<int>();
     int longP = params.at("long_period").get<int>();
 
-    return makeSmaCrossoverStrategy(symbol, shortP, longP);
+    return makeSmaCrossoverStrategy(symbol, shortP, longP, resource);
   }
   else if(stratName == "breakout")
   {
     std::size_t lb = params.at("lookback_window").get<std::size_t>();
-    return makeBreakoutStrategy(symbol, lb);
+    return makeBreakoutStrategy(symbol, lb, resource);
   }
 
   else if(stratName == "mean_reversion_zscore")
@@ -79,8 +91,48 @@ createStrategy(const std::string &symbol,
     double entryZ = params.at("entry_zscore").get<double>();
     double exitZ = params.at("exit_zscore").get<double>();
 
-    return makeZScoreMeanReversionStrategy(symbol, lookback, entryZ, exitZ);
+    return makeZScoreMeanReversionStrategy(symbol, lookback, entryZ, exitZ, resource);
   }
 
   throw std::runtime_error("Unsupported strategy name: " + stratName);
 }
+
+// register cross-sectional strategy names for config.json
+std::unique_ptr<CrossSectionalStrategy_I>
+createCrossSectionalStrategy(const std::vector<std::string> &symbols,
+                             const nlohmann::json &stratCfg,
+                             std::pmr::memory_resource *resource)
+{
+  std::string stratName = stratCfg.at("name").get<std::string>();
+  const auto &params = stratCfg.at("params");
+
+  if(stratName == "momentum_rank")
+  {
+    // Read signed so a negative value is rejected rather than wrapped.
+    const auto lookback = params.at("lookback").get<std::int64_t>();
+    const auto topN = params.at("top_n").get<std::int64_t>();
+    if(lookback < 1 || topN < 1)
+    {
+      throw std::runtime_error("momentum_rank needs lookback >= 1 and top_n >= 1");
+    }
+
+    return makeMomentumRankStrategy(symbols.size(), static_cast<std::size_t>(lookback),
+                                    static_cast<std::size_t>(topN), resource);
+  }
+
+  throw std::runtime_error("Unsupported cross-sectional strategy name: " + stratName);
+}
+
+std::unique_ptr<SimpleExecutionEngine> createExecutionEngine(const nlohmann::json &engineCfg)
+{
+  auto exec = std::make_unique<SimpleExecutionEngine>();
+  exec->setDefaultTickSize(engineCfg.value("tick_size", 0.0));
+  // Bound to a local: items() of the temporary value() returns would
+  // outlive it in a C++17 range-for.
+  const auto tickSizes = engineCfg.value("tick_sizes", nlohmann::json::object());
+  for(const auto &[symbol, tick] : tickSizes.items())
+  {
+    exec->setTickSize(symbol, tick.get<double>());
+  }
+  return exec;
+}
@@ -0,0 +1,169 @@
+#include "SweepRunner.hpp"
+#include "BacktestEngine.hpp"
+#include "Log.hpp"
+#include "RunArena.hpp"
+#include "Trace.hpp"
+#include "StrategyFactory.hpp"
+#include "exec/SimpleExecutionEngine.hpp"
+#include "feed/BarColumnsFeed.hpp"
+#include "feed/CandleViewFeed.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+
+using nlohmann::json;
+
+SweepRunner::SweepRunner(std::vector<Candle> candles,
+                         const json &stratCfg,
+                         double initialCash,
+                         DataPrecision precision,
+                         ExecutionMaker makeExecution)
+  : candles_(std::move(candles)),
+    precision_(precision),
+    configs_(expandGrid(stratCfg)),
+    initialCash_(initialCash),
+    makeExecution_(std::move(makeExecution))
+{
+  if(candles_.empty())
+  {
+    throw std::invalid_argument("SweepRunner: no candles");
+  }
+  symbol_ = candles_.front().symbol;
+  if(!makeExecution_)
+  {
+    makeExecution_ = [] { return std::make_unique<SimpleExecutionEngine>(); };
+  }
+
+  if(precision_ == DataPrecision::Float32)
+  {
+    columns32_ = toBarColumns<float>(candles_);
+    std::vector<Candle>().swap(candles_);
+  }
+}
+
+std::vector<json> SweepRunner::expandGrid(const json &stratCfg)
+{
+  std::vector<json> grid{ stratCfg };
+
+  // json objects iterate in key order, so the expansion is deterministic.
+  for(const auto &[name, values] : stratCfg.at("params").items())
+  {
+    if(!values.is_array())
+    {
+      continue;
+    }
+    if(values.empty())
+    {
+      throw std::runtime_error("Sweep parameter '" + name + "' has no values");
+    }
+
+    std::vector<json> next;
+    next.reserve(grid.size() * values.size());
+    for(const auto &point : grid)
+    {
+      for(const auto &v : values)
+      {
+        json cfg = point;
+        cfg["params"][name] = v;
+        next.push_back(std::move(cfg));
+      }
+    }
+    grid = std::move(next);
+  }
+
+  return grid;
+}
+
+SweepResult SweepRunner::runOne(const json &stratCfg,
+                                std::pmr::memory_resource *resource) const
+{
+  auto strategy = createStrategy(symbol_, stratCfg, resource);
+  std::unique_ptr<DataFeed_I> feed;
+  if(precision_ == DataPrecision::Float32)
+  {
+    // The engine reads the close to fill and mark.
+    BarFields fields = strategy->barFields();
+    fields |= BarField::Close;
+    feed = std::make_unique<BarColumnsFeed<float>>(columns32_, fields);
+  }
+  else
+  {
+    feed = std::make_unique<CandleViewFeed>(candles_);
+  }
+
+  BacktestEngine engine(std::move(strategy),
+                        makeExecution_(),
+                        std::move(feed),
+                        initialCash_,
+                        resource);
+
+  SweepResult result;
+  result.report = engine.run();
+  result.finalEquity = engine.portfolio().getEquity();
+  result.trades = engine.ledger().size();
+  result.allocs = engine.allocStats();
+  result.params = stratCfg.at("params");
+  return result;
+}
+
+std::vector<SweepResult> SweepRunner::run(std::size_t threads, bool useArenas) const
+{
+  const std::size_t n = configs_.size();
+  if(threads == 0)
+  {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  threads = std::min(threads, n);
+
+  std::vector<SweepResult> results(n);
+  std::vector<std::exception_ptr> errors(n);
+  std::atomic<std::size_t> nextRun{ 0 };
+
+  auto worker = [&](std::size_t w)
+  {
+    if(Trace::enabled())
+    {
+      Trace::setThreadName("sweep worker " + std::to_string(w));
+    }
+
+    RunArena arena;
+    for(std::size_t i = nextRun++; i < n; i = nextRun++)
+    {
+      TraceScope trace("sweep run", static_cast<std::int64_t>(i));
+      LogContext context("sweep run", static_cast<std::int64_t>(i));
+      try
+      {
+        results[i] = runOne(configs_[i],
+                            useArenas ? arena.resource() : std::pmr::get_default_resource());
+      }
+      catch(...)
+      {
+        errors[i] = std::current_exception();
+      }
+      arena.reset();
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for(std::size_t t = 1; t < threads; ++t)
+  {
+    pool.emplace_back(worker, t);
+  }
+  worker(0);
+  for(auto &t : pool)
+  {
+    t.join();
+  }
+
+  for(const auto &e : errors)
+  {
+    if(e)
+    {
+      std::rethrow_exception(e);
+    }
+  }
+
+  return results;
+}
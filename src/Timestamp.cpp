@@ -0,0 +1,187 @@
+#include "Timestamp.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+namespace
+{
+
+// Howard Hinnant's days_from_civil / civil_from_days.
+std::int64_t daysFromCivil(std::int64_t y, unsigned m, unsigned d)
+{
+  y -= m <= 2 ? 1 : 0;
+  const std::int64_t era = (y >= 0 ? y : y - 399) / 400;
+  const auto yoe = static_cast<unsigned>(y - era * 400);
+  const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+  const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+}
+
+void civilFromDays(std::int64_t z, std::int64_t &y, unsigned &m, unsigned &d)
+{
+  z += 719468;
+  const std::int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+  const auto doe = static_cast<unsigned>(z - era * 146097);
+  const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const unsigned mp = (5 * doy + 2) / 153;
+  d = doy - (153 * mp + 2) / 5 + 1;
+  m = mp < 10 ? mp + 3 : mp - 9;
+  y = static_cast<std::int64_t>(yoe) + era * 400 + (m <= 2 ? 1 : 0);
+}
+
+unsigned digits(const std::string &ts, std::size_t pos, std::size_t count)
+{
+  unsigned v = 0;
+  for(std::size_t i = pos; i < pos + count; ++i)
+  {
+    char c = ts[i];
+    if(c < '0' || c > '9')
+    {
+      throw std::invalid_argument("Malformed timestamp: " + ts);
+    }
+    v = v * 10 + static_cast<unsigned>(c - '0');
+  }
+  return v;
+}
+
+} // namespace
+
+std::int64_t parseTimestamp(const std::string &ts)
+{
+  // Exactly "YYYY-MM-DD", "YYYY-MM-DD HH:MM" or "YYYY-MM-DD HH:MM:SS":
+  // anything else (a truncated time, a trailing zone) would otherwise be
+  // read as a different instant.
+  const std::size_t n = ts.size();
+  if((n != 10 && n != 16 && n != 19) || ts[4] != '-' || ts[7] != '-'
+     || (n > 10 && (ts[10] != ' ' || ts[13] != ':')) || (n == 19 && ts[16] != ':'))
+  {
+    throw std::invalid_argument("Malformed timestamp: " + ts);
+  }
+
+  const unsigned y = digits(ts, 0, 4);
+  const unsigned m = digits(ts, 5, 2);
+  const unsigned d = digits(ts, 8, 2);
+  const bool leap = (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+  const unsigned monthDays[] = { 31, leap ? 29u : 28u, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+  if(m < 1 || m > 12 || d < 1 || d > monthDays[m - 1])
+  {
+    throw std::invalid_argument("Timestamp date out of range: " + ts);
+  }
+
+  std::int64_t secs = 0;
+  if(n > 10)
+  {
+    const unsigned hh = digits(ts, 11, 2);
+    const unsigned mm = digits(ts, 14, 2);
+    const unsigned ss = n == 19 ? digits(ts, 17, 2) : 0;
+    if(hh > 23 || mm > 59 || ss > 59)
+    {
+      throw std::invalid_argument("Timestamp time out of range: " + ts);
+    }
+    secs = hh * 3600 + mm * 60 + ss;
+  }
+  return daysFromCivil(y, m, d) * 86400 + secs;
+}
+
+void formatTimestamp(std::int64_t seconds, std::string &out)
+{
+  std::int64_t days = seconds >= 0 ? seconds / 86400 : (seconds - 86399) / 86400;
+  std::int64_t secs = seconds - days * 86400;
+
+  std::int64_t y = 0;
+  unsigned m = 0;
+  unsigned d = 0;
+  civilFromDays(days, y, m, d);
+
+  if(y < 0 || y > 9999)
+  {
+    char buf[64];
+    int n = 0;
+    if(secs == 0)
+    {
+      n = std::snprintf(buf, sizeof(buf), "%04lld-%02u-%02u",
+                        static_cast<long long>(y), m, d);
+    }
+    else
+    {
+      n = std::snprintf(buf, sizeof(buf), "%04lld-%02u-%02u %02lld:%02lld:%02lld",
+                        static_cast<long long>(y), m, d,
+                        static_cast<long long>(secs / 3600),
+                        static_cast<long long>((secs / 60) % 60),
+                        static_cast<long long>(secs % 60));
+    }
+    out.assign(buf, static_cast<std::size_t>(n));
+    return;
+  }
+
+  // Feeds decoding stored times call this once per bar, so the common
+  // four-digit years skip snprintf (several times slower).
+  char buf[19];
+  auto put2 = [&buf](std::size_t at, std::int64_t v)
+  {
+    buf[at] = static_cast<char>('0' + v / 10);
+    buf[at + 1] = static_cast<char>('0' + v % 10);
+  };
+  put2(0, y / 100);
+  put2(2, y % 100);
+  buf[4] = '-';
+  put2(5, m);
+  buf[7] = '-';
+  put2(8, d);
+  std::size_t n = 10;
+  if(secs != 0)
+  {
+    buf[10] = ' ';
+    put2(11, secs / 3600);
+    buf[13] = ':';
+    put2(14, (secs / 60) % 60);
+    buf[16] = ':';
+    put2(17, secs % 60);
+    n = 19;
+  }
+  out.assign(buf, n);
+}
+
+std::string formatTimestamp(std::int64_t seconds)
+{
+  std::string out;
+  formatTimestamp(seconds, out);
+  return out;
+}
+
+TimeRange parseTimeRange(const std::string &start, const std::string &end)
+{
+  TimeRange range;
+  if(!start.empty())
+  {
+    range.start = parseTimestamp(start);
+  }
+  if(!end.empty())
+  {
+    range.end = parseTimestamp(end);
+    if(end.size() == 10)
+    {
+      range.end += 86400 - 1;
+    }
+  }
+  if(range.start > range.end)
+  {
+    throw std::runtime_error("Time range starts after it ends: " + start + " > " + end);
+  }
+  return range;
+}
+
+std::pair<std::size_t, std::size_t> selectRows(const std::int64_t *time, std::size_t count,
+                                               const TimeRange &range, int lookbackBars)
+{
+  auto first = static_cast<std::size_t>(std::lower_bound(time, time + count, range.start) - time);
+  auto last = static_cast<std::size_t>(std::upper_bound(time + first, time + count, range.end)
+                                       - time);
+  if(lookbackBars > 0 && static_cast<std::size_t>(lookbackBars) < last - first)
+  {
+    first = last - static_cast<std::size_t>(lookbackBars);
+  }
+  return { first, last };
+}
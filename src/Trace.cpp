@@ -0,0 +1,155 @@
+#include "Trace.hpp"
+#include "AllocTracker.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+namespace
+{
+
+struct Span
+{
+  const char *name;
+  std::int64_t id;
+  std::int64_t start;
+  std::int64_t end;
+};
+
+// Written only by its thread; `written` is published with release so a
+// reader sees every span below it.
+struct ThreadRing
+{
+  ThreadRing(std::size_t spanCount, std::size_t threadId)
+    : spans(new Span[spanCount]), capacity(spanCount), tid(threadId) {}
+
+  std::unique_ptr<Span[]> spans;
+  std::size_t capacity;
+  std::size_t tid;
+  std::atomic<std::uint64_t> written{ 0 };
+  std::string name; // guarded by registryMutex
+};
+
+// Rings outlive their threads so sweep workers that have exited still
+// show up in the dump.
+std::mutex registryMutex;
+std::vector<std::unique_ptr<ThreadRing>> registry;
+std::size_t ringCapacity = 1u << 16;
+std::chrono::steady_clock::time_point epoch;
+
+thread_local ThreadRing *threadRing = nullptr;
+
+ThreadRing &ringOfThisThread()
+{
+  if(threadRing == nullptr)
+  {
+    // Once per thread, possibly inside a trapped bar loop.
+    AllocAllowScope allow;
+    std::lock_guard<std::mutex> lock(registryMutex);
+    registry.push_back(std::make_unique<ThreadRing>(ringCapacity, registry.size() + 1));
+    threadRing = registry.back().get();
+  }
+  return *threadRing;
+}
+
+} // namespace
+
+void Trace::enable(std::size_t spansPerThread)
+{
+  {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    if(registry.empty())
+    {
+      ringCapacity = spansPerThread > 0 ? spansPerThread : 1;
+      epoch = std::chrono::steady_clock::now();
+    }
+  }
+  enabled_.store(true, std::memory_order_release);
+}
+
+void Trace::setThreadName(const std::string &name)
+{
+  if(!enabled())
+  {
+    return;
+  }
+  ThreadRing &ring = ringOfThisThread();
+  std::lock_guard<std::mutex> lock(registryMutex);
+  ring.name = name;
+}
+
+std::int64_t Trace::now()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now() - epoch)
+    .count();
+}
+
+void Trace::record(const char *name, std::int64_t id, std::int64_t start, std::int64_t end)
+{
+  ThreadRing &ring = ringOfThisThread();
+  const std::uint64_t n = ring.written.load(std::memory_order_relaxed);
+  ring.spans[n % ring.capacity] = { name, id, start, end };
+  ring.written.store(n + 1, std::memory_order_release);
+}
+
+void Trace::writeChromeTrace(std::ostream &out)
+{
+  std::lock_guard<std::mutex> lock(registryMutex);
+
+  // Timestamps are microseconds; keep the nanoseconds as decimals.
+  auto micros = [&](std::int64_t ns)
+  {
+    out << ns / 1000 << '.' << static_cast<char>('0' + ns / 100 % 10)
+        << static_cast<char>('0' + ns / 10 % 10) << static_cast<char>('0' + ns % 10);
+  };
+
+  std::uint64_t dropped = 0;
+  bool first = true;
+  out << "{\"traceEvents\":[\n";
+  for(const auto &ring : registry)
+  {
+    if(!ring->name.empty())
+    {
+      out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+          << ring->tid << ",\"args\":{\"name\":" << nlohmann::json(ring->name).dump() << "}}";
+      first = false;
+    }
+
+    const std::uint64_t written = ring->written.load(std::memory_order_acquire);
+    const std::uint64_t kept = std::min<std::uint64_t>(written, ring->capacity);
+    dropped += written - kept;
+    for(std::uint64_t i = written - kept; i < written; ++i)
+    {
+      const Span &s = ring->spans[i % ring->capacity];
+      out << (first ? "" : ",\n") << "{\"name\":\"" << s.name
+          << "\",\"cat\":\"backtest\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->tid << ",\"ts\":";
+      micros(s.start);
+      out << ",\"dur\":";
+      micros(s.end - s.start);
+      if(s.id >= 0)
+      {
+        out << ",\"args\":{\"id\":" << s.id << "}";
+      }
+      out << "}";
+      first = false;
+    }
+  }
+  out << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped_spans\":" << dropped << "}}\n";
+}
+
+void Trace::writeChromeTrace(const std::string &path)
+{
+  std::ofstream out(path, std::ios::trunc);
+  if(!out)
+  {
+    throw std::runtime_error("Failed to open trace file: " + path);
+  }
+  writeChromeTrace(out);
+}
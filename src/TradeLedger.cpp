@@ -0,0 +1,184 @@
+#include "TradeLedger.hpp"
+#include "Timestamp.hpp"
+#include "AllocTracker.hpp"
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable<TradeRecord>::value,
+              "TradeRecord is written to disk verbatim");
+static_assert(sizeof(TradeRecord) == 48, "TradeRecord layout changed");
+
+TradeLedger::TradeLedger(std::size_t memoryLimitBytes,
+                         std::string spillPath,
+                         std::pmr::memory_resource *resource)
+  : memoryLimitBytes_(std::max(memoryLimitBytes, chunkRecords * sizeof(TradeRecord))),
+    spillPath_(std::move(spillPath)),
+    chunks_(resource),
+    spare_(resource),
+    symbols_(resource),
+    ids_(resource)
+{
+}
+
+std::size_t TradeLedger::inMemory() const
+{
+  return chunks_.empty() ? 0 : (chunks_.size() - 1) * chunkRecords + tailCount_;
+}
+
+void TradeLedger::record(const Fill &fill, double realizedPnL)
+{
+  if(tailCount_ == chunkRecords)
+  {
+    // One allocation per chunkRecords fills; the ledger grows by design.
+    AllocAllowScope allow;
+
+    if(!spillPath_.empty() && (chunks_.size() + 1) * chunkRecords * sizeof(TradeRecord) > memoryLimitBytes_)
+    {
+      spill();
+    }
+
+    if(!spare_.empty())
+    {
+      chunks_.push_back(std::move(spare_.back()));
+      spare_.pop_back();
+      chunks_.back().clear();
+    }
+    else
+    {
+      // Reserve rather than size the chunk: a short run should not pay to
+      // zero a whole chunk it will barely use.
+      chunks_.emplace_back();
+      chunks_.back().reserve(chunkRecords);
+    }
+    tailCount_ = 0;
+  }
+
+  auto it = ids_.find(fill.symbol);
+  if(it == ids_.end())
+  {
+    AllocAllowScope allow;
+    it = ids_.emplace(fill.symbol, static_cast<std::uint32_t>(symbols_.size())).first;
+    symbols_.push_back(fill.symbol);
+  }
+
+  const bool adds = fill.side == OrderSide::Buy || fill.side == OrderSide::Cover;
+
+  TradeRecord &r = chunks_.back().emplace_back();
+  ++tailCount_;
+  r.timestamp = parseTimestamp(fill.timestamp);
+  r.price = fromMoney(fill.price);
+  r.fees = fromMoney(fill.fees);
+  r.realizedPnL = realizedPnL;
+  r.symbolId = it->second;
+  r.quantity = adds ? fill.quantity : -fill.quantity;
+  r.side = static_cast<std::uint8_t>(fill.side);
+}
+
+void TradeLedger::spill()
+{
+  TraceScope trace("ledger spill");
+  if(!spillOut_.is_open())
+  {
+    spillOut_.open(spillPath_, std::ios::binary | std::ios::trunc);
+    if(!spillOut_)
+    {
+      throw std::runtime_error("Failed to open trade ledger spill file: " + spillPath_);
+    }
+  }
+
+  // Every chunk is full at this point; write them and keep their memory.
+  for(auto &chunk : chunks_)
+  {
+    spillOut_.write(reinterpret_cast<const char *>(chunk.data()),
+                    static_cast<std::streamsize>(chunkRecords * sizeof(TradeRecord)));
+    spare_.push_back(std::move(chunk));
+  }
+  if(!spillOut_)
+  {
+    throw std::runtime_error("Failed to write trade ledger spill file: " + spillPath_);
+  }
+
+  spilled_ += chunks_.size() * chunkRecords;
+  chunks_.clear();
+}
+
+std::ifstream TradeLedger::openSpilled() const
+{
+  spillOut_.flush();
+  std::ifstream in(spillPath_, std::ios::binary);
+  if(!in)
+  {
+    throw std::runtime_error("Failed to open trade ledger spill file: " + spillPath_);
+  }
+  return in;
+}
+
+void TradeLedger::readSpilled(std::ifstream &in,
+                              std::vector<TradeRecord> &buffer,
+                              std::size_t offset) const
+{
+  in.seekg(static_cast<std::streamoff>(offset * sizeof(TradeRecord)));
+
+  const std::size_t count = std::min(chunkRecords, spilled_ - offset);
+  buffer.resize(count);
+  in.read(reinterpret_cast<char *>(buffer.data()),
+          static_cast<std::streamsize>(count * sizeof(TradeRecord)));
+  if(!in)
+  {
+    throw std::runtime_error("Failed to read trade ledger spill file: " + spillPath_);
+  }
+}
+
+std::vector<SymbolPnL> TradeLedger::pnlBySymbol() const
+{
+  std::vector<SymbolPnL> out(symbols_.size());
+  for(std::size_t i = 0; i < symbols_.size(); ++i)
+  {
+    out[i].symbol = symbols_[i];
+  }
+
+  forEach([&out](const TradeRecord &r)
+  {
+    SymbolPnL &s = out[r.symbolId];
+    s.realizedPnL += r.realizedPnL;
+    s.fees += r.fees;
+    ++s.trades;
+  });
+  return out;
+}
+
+std::vector<HoldingPeriod> TradeLedger::holdingPeriods() const
+{
+  std::vector<HoldingPeriod> out;
+  std::vector<int> position(symbols_.size(), 0);
+  std::vector<std::size_t> open(symbols_.size(), 0);
+
+  forEach([&](const TradeRecord &r)
+  {
+    int &pos = position[r.symbolId];
+    const int before = pos;
+    pos += r.quantity;
+
+    // Closing or flipping through zero ends the current holding.
+    if(before != 0 && (pos == 0 || (before > 0) != (pos > 0)))
+    {
+      out[open[r.symbolId]].closed = r.timestamp;
+    }
+    // Opening from flat, or the far side of a flip, starts a new one.
+    if(pos != 0 && (before == 0 || (before > 0) != (pos > 0)))
+    {
+      open[r.symbolId] = out.size();
+      out.push_back({ symbols_[r.symbolId], r.timestamp, 0, 0 });
+    }
+    if(pos != 0)
+    {
+      HoldingPeriod &h = out[open[r.symbolId]];
+      h.maxQuantity = std::max(h.maxQuantity, std::abs(pos));
+    }
+  });
+  return out;
+}
@@ -0,0 +1,69 @@
+#include "feed/UniverseFeed.hpp"
+
+#include <stdexcept>
+
+UniverseFeed::UniverseFeed(std::unique_ptr<MergedFeed> merged)
+  : merged_(std::move(merged))
+{
+  const std::size_t n = merged_->symbolCount();
+  symbols_.reserve(n);
+  for(std::size_t i = 0; i < n; ++i)
+  {
+    symbols_.push_back(merged_->symbol(i));
+    ids_.emplace(symbols_.back(), i);
+  }
+
+  close_.assign(n, 0.0);
+  volume_.assign(n, 0.0);
+  valid_.assign(n, 0);
+  bars_.assign(n, nullptr);
+  touched_.reserve(n);
+
+  view_.size = n;
+  view_.timestamp = &timestamp_;
+  view_.close = close_.data();
+  view_.volume = volume_.data();
+  view_.valid = valid_.data();
+}
+
+const UniverseView &UniverseFeed::nextSlice()
+{
+  if(!merged_->hasNext())
+  {
+    throw std::out_of_range("UniverseFeed::nextSlice called with no more data");
+  }
+
+  // Only reset the symbols the previous slice touched; close/volume keep
+  // their last known values for symbols that do not trade this slice.
+  for(std::size_t id : touched_)
+  {
+    valid_[id] = 0;
+    bars_[id] = nullptr;
+  }
+  touched_.clear();
+
+  do
+  {
+    const Candle &bar = merged_->next();
+    const std::size_t id = merged_->lastSymbolId();
+    close_[id] = bar.close;
+    volume_[id] = bar.volume;
+    valid_[id] = 1;
+    bars_[id] = &bar;
+    touched_.push_back(id);
+    timestamp_ = bar.timestamp;
+  } while(!merged_->endOfSlice());
+
+  return view_;
+}
+
+std::size_t UniverseFeed::idOf(const std::string &symbol) const
+{
+  auto it = ids_.find(symbol);
+  return it != ids_.end() ? it->second : symbols_.size();
+}
+
+const Candle *UniverseFeed::bar(std::size_t id) const
+{
+  return id < bars_.size() ? bars_[id] : nullptr;
+}
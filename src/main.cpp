@@ -1,17 +1,32 @@
+#include <algorithm>
+#include <csignal>
 #include <cstdlib>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <optional>
 #include <stdexcept>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <nlohmann/json.hpp>
 
 #include "BacktestEngine.hpp"
-#include "feed/AlphaVantageFeed.hpp"
-#include "exec/SimpleExecutionEngine.hpp"
-#include "Strategy_I.hpp"
+#include "BacktestServer.hpp"
 #include "StrategyFactory.hpp"
+#include "ResultCache.hpp"
+#include "RunBuilder.hpp"
+#include "SegmentedBacktest.hpp"
+#include "SharedDataset.hpp"
+#include "SweepRunner.hpp"
+#include "AllocTracker.hpp"
+#include "FileUtil.hpp"
+#include "Hash.hpp"
+#include "Log.hpp"
+#include "PerfCounters.hpp"
+#include "Trace.hpp"
 
 using nlohmann::json;
 
@@ -27,10 +42,151 @@ static json loadConfig(const std::string &path)
   return cfg;
 }
 
+// Identity of a checkpointed run: the strategy config, the symbols, the
+// initial cash and the engine settings that change results. Resuming a
+// checkpoint of another run would splice two different simulations.
+static std::uint64_t checkpointIdentity(const std::vector<std::string> &symbols,
+                                        const json &stratCfg,
+                                        const json &engineCfg,
+                                        double initialCash)
+{
+  json settings = engineCfg;
+  for(const char *key : { "pipelined", "perf_counters", "alloc_tracking", "threads" })
+  {
+    settings.erase(key);
+  }
+
+  Hasher64 h;
+  h.addString(stratCfg.dump());
+  h.addU64(symbols.size());
+  for(const auto &symbol : symbols)
+  {
+    h.addString(symbol);
+  }
+  h.addDouble(initialCash);
+  // nlohmann::json objects keep their keys sorted, so dump() is canonical.
+  h.addString(settings.dump());
+  return h.digest();
+}
+
+// Loader mode: fetch a config's candles once and publish them to shared
+// memory for any number of runs with the "shared_memory" provider.
+static int publish(const std::string &configPath, const std::string &name)
+{
+  json cfg = loadConfig(configPath);
+  std::vector<std::vector<Candle>> series = fetchSeries(cfg.at("data"), configSymbols(cfg));
+  Log::flush();
+
+  std::size_t bytes = publishSharedDataset(name, series);
+  std::cout << "Published " << series.size() << " symbols as shared dataset '" << name
+            << "' (" << static_cast<double>(bytes) / (1 << 20) << " MiB)\n";
+  return 0;
+}
+
+// Enables tracing for the process and writes the timeline on every way
+// out of main, errors included.
+class TraceFile
+{
+public:
+  explicit TraceFile(std::string path)
+    : path_(std::move(path))
+  {
+    if(!path_.empty())
+    {
+      Trace::enable();
+      Trace::setThreadName("main");
+    }
+  }
+
+  ~TraceFile()
+  {
+    if(path_.empty())
+    {
+      return;
+    }
+    try
+    {
+      Trace::writeChromeTrace(path_);
+      std::cout << "Trace written to " << path_ << "\n";
+    }
+    catch(const std::exception &ex)
+    {
+      std::cerr << "WARNING: " << ex.what() << "\n";
+    }
+  }
+
+  TraceFile(const TraceFile &) = delete;
+  TraceFile &operator=(const TraceFile &) = delete;
+
+private:
+  std::string path_;
+};
+
+static BacktestServer *activeServer = nullptr;
+
+static void stopServer(int)
+{
+  if(activeServer != nullptr)
+  {
+    activeServer->stop();
+  }
+}
+
+// Daemon mode: serve jobs until SIGINT/SIGTERM, keeping datasets loaded.
+static int serve(const std::string &socketPath, std::size_t threads)
+{
+  Log::setLevel(LogLevel::Warn);
+
+  BacktestServer server(socketPath, threads);
+  activeServer = &server;
+
+  struct sigaction action{};
+  action.sa_handler = stopServer;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGINT, &action, nullptr);
+  sigaction(SIGTERM, &action, nullptr);
+
+  std::cout << "Serving backtests on " << socketPath << std::endl;
+  server.serve();
+  activeServer = nullptr;
+  std::cout << "Server stopped\n";
+  return 0;
+}
+
+static void printResults(double initialCash, double finalEquity, const Report &r)
+{
+  // Strategy messages of the run come out before the results.
+  Log::flush();
+  std::cout << "\n===== Backtest Results =====\n";
+  std::cout << "Initial equity: " << initialCash << "\n";
+  std::cout << "Final equity:   " << finalEquity << "\n";
+  std::cout << "Total return:   " << r.totalReturn * 100.0 << "%\n";
+  std::cout << "CAGR:           " << r.cagr * 100.0 << "%\n";
+  std::cout << "Sharpe:         " << r.sharpe << "\n";
+  std::cout << "Max drawdown:   " << r.maxDrawdown * 100.0 << "%\n";
+  std::cout << "Realized PnL:   " << r.realizedPnL << "\n";
+  std::cout << "Unrealized PnL: " << r.unrealizedPnL << "\n";
+}
+
 int main(int argc, char **argv)
 {
   try
   {
+    if(argc > 2 && std::string(argv[1]) == "--serve")
+    {
+      return serve(argv[2], argc > 3 ? std::stoul(argv[3]) : 0);
+    }
+    if(argc > 3 && std::string(argv[1]) == "--publish")
+    {
+      return publish(argv[2], argv[3]);
+    }
+    if(argc > 2 && std::string(argv[1]) == "--unpublish")
+    {
+      bool removed = removeSharedDataset(argv[2]);
+      std::cout << (removed ? "Removed" : "No") << " shared dataset '" << argv[2] << "'\n";
+      return 0;
+    }
+
     std::string configPath = "config.json";
     if(argc > 1)
     {
@@ -39,75 +195,303 @@ int main(int argc, char **argv)
 
     json cfg = loadConfig(configPath);
 
-    // Top-level config
-    std::string symbol = cfg.at("asset").get<std::string>();
+    // Optional Chrome trace of the run ("trace": "out.json").
+    TraceFile traceFile(cfg.value("trace", std::string{}));
+
+    Log::setLevel(parseLogLevel(cfg.value("log_level", std::string{ "info" })));
+
+    std::vector<std::string> symbols = configSymbols(cfg);
     double initialCash = cfg.at("initial_cash").get<double>();
 
-    // Data config
+    // Engine settings
+    json engineCfg = cfg.value("engine", json::object());
+    std::string mode = engineCfg.value("mode", std::string{ "per_bar" });
+
+    // Strategy config
+    const auto &stratCfg = cfg.at("strategy");
+    std::string stratName = stratCfg.at("name").get<std::string>();
+    const BarFields fields = runBarFields(mode, symbols, stratCfg);
+
+    // Data config. A "shared_memory" dataset (see --publish) is read in
+    // place by per_bar runs; other modes copy their symbols' bars out.
     const auto &dataCfg = cfg.at("data");
-    std::string provider = dataCfg.at("provider").get<std::string>();
-    std::string interval = dataCfg.at("interval").get<std::string>();
-    int lookbackBars = dataCfg.at("lookback_bars").get<int>();
+    RunData data = loadRunData(dataCfg, symbols, mode, fields);
+
+    Log::flush();
 
-    std::unique_ptr<DataFeed_I> feed;
+    std::string checkpointPath = cfg.value("checkpoint", std::string{});
 
-    if(provider == "alpha_vantage")
+    // Optional result cache. Checkpointed runs bypass it because they must
+    // advance their checkpoint even when the result is already known.
+    std::optional<ResultCache> cache;
+    std::string cacheKey;
+    std::string cacheDir = cfg.value("result_cache", std::string{});
+    if(!cacheDir.empty() && checkpointPath.empty())
     {
-      if(interval != "daily")
+      json runCfg = cfg;
+      runCfg.erase("result_cache");
+      runCfg.erase("trace");
+      runCfg.erase("log_level");
+
+      cache.emplace(cacheDir);
+      std::uint64_t dataHash = 0;
+      if(data.shared)
+      {
+        std::vector<std::uint64_t> hashes;
+        for(std::size_t id : data.sharedIds)
+        {
+          hashes.push_back(data.shared->series(id).hash);
+        }
+        dataHash = combineSeriesHashes(hashes);
+      }
+      else
       {
-        std::cerr << "WARNING: only 'daily' supported; got '"
-                  << interval << "'. Using daily.\n";
+        dataHash = hashCandles(data.series);
       }
+      cacheKey = ResultCache::makeKey(dataHash, runCfg);
 
-      const char *keyEnv = std::getenv("ALPHAVANTAGE_API_KEY");
-      if(!keyEnv)
+      if(auto hit = cache->lookup(cacheKey))
       {
-        throw std::runtime_error("ALPHAVANTAGE_API_KEY is not set");
+        std::cout << "Result cache hit (" << cacheKey << "), skipping backtest\n";
+        printResults(initialCash, hit->finalEquity, hit->report);
+        return 0;
       }
-      std::string apiKey = keyEnv;
+    }
 
-      feed = makeAlphaVantageFeed(apiKey, symbol, lookbackBars);
+    std::cout << "Running backtest...\n";
+    std::cout << "  Strategy: " << stratName << "\n";
+    std::cout << "  Symbols:  " << symbols.size() << " (" << symbols.front()
+              << (symbols.size() > 1 ? ", ..." : "") << ")\n";
+    std::cout << "  Cash:     " << initialCash << "\n";
+    std::cout << "  Mode:     " << mode << "\n";
+
+    // Allocation tracking: "report" prints heap allocations per engine
+    // phase, "strict" also aborts on any allocation in the steady-state
+    // bar loop. Needs a build with -DBACKTEST_ALLOC_TRACKING=ON.
+    std::string allocTracking = engineCfg.value("alloc_tracking", std::string{ "off" });
+    if(allocTracking != "off" && allocTracking != "report" && allocTracking != "strict")
+    {
+      throw std::runtime_error("Unsupported alloc_tracking setting: " + allocTracking);
     }
-    else
+    const bool reportAllocs = allocTracking != "off";
+    if(reportAllocs && !AllocTracker::enabled)
     {
-      throw std::runtime_error("Unsupported data provider: " + provider);
+      std::cerr << "WARNING: alloc_tracking requested but this build has no "
+                   "allocation hooks (configure with -DBACKTEST_ALLOC_TRACKING=ON)\n";
     }
+    AllocTracker::setStrict(allocTracking == "strict");
 
-    // Strategy config
-    const auto &stratCfg = cfg.at("strategy");
-    std::string stratName = stratCfg.at("name").get<std::string>();
+    // Hardware counters around the engine run: "run" for the whole run,
+    // "phases" for a per-phase breakdown (a syscall per phase change).
+    std::string perfSetting = engineCfg.value("perf_counters", std::string{ "off" });
+    PerfMode perfMode = PerfMode::Off;
+    if(perfSetting == "run")
+    {
+      perfMode = PerfMode::Run;
+    }
+    else if(perfSetting == "phases")
+    {
+      perfMode = PerfMode::Phases;
+    }
+    else if(perfSetting != "off")
+    {
+      throw std::runtime_error("Unsupported perf_counters setting: " + perfSetting);
+    }
+    if(perfMode != PerfMode::Off && (mode == "segmented" || mode == "sweep"))
+    {
+      std::cerr << "WARNING: perf_counters is only supported in per_bar and "
+                   "cross_sectional mode\n";
+    }
+
+    // Stored type of the sweep history; see BarColumns.hpp.
+    const DataPrecision precision =
+      parseDataPrecision(dataCfg.value("precision", std::string{ "float64" }));
+    if(precision != DataPrecision::Float64 && mode != "sweep")
+    {
+      std::cerr << "WARNING: data precision float32 is only supported in sweep mode\n";
+    }
 
-    // Let the factory decide which concrete strategy to build
-    std::unique_ptr<Strategy_I> strategy = createStrategy(symbol, stratCfg);
+    if(mode == "segmented")
+    {
+      // Segment-parallel single-symbol run; see SegmentedBacktest.
+      if(symbols.size() != 1 || !checkpointPath.empty())
+      {
+        throw std::runtime_error("Segmented mode supports one asset and no checkpoint");
+      }
 
-    auto exec = std::make_unique<SimpleExecutionEngine>();
+      const std::string symbol = symbols.front();
+      SegmentedBacktest segmented(
+        std::move(data.series.front()),
+        [&] { return createStrategy(symbol, stratCfg); },
+        [&] { return createExecutionEngine(engineCfg); },
+        initialCash,
+        engineCfg.value("segments", std::size_t{ 8 }));
 
-    std::cout << "Running backtest...\n";
-    std::cout << "  Strategy: " << stratName << "\n";
-    std::cout << "  Symbol:   " << symbol << "\n";
-    std::cout << "  Cash:     " << initialCash << "\n";
+      SegmentedResult result = segmented.runParallel(engineCfg.value("threads", std::size_t{ 0 }));
+      std::cout << "  Segments: " << segmented.segmentCount() << "\n";
+
+      if(engineCfg.value("validate", false))
+      {
+        SegmentedResult serial = segmented.runSerial();
+        bool ok = SegmentedBacktest::equivalent(result, serial);
+        std::cout << "  Serial equivalence: " << (ok ? "OK" : "MISMATCH") << "\n";
+        if(!ok)
+        {
+          throw std::runtime_error("Segmented run does not match the serial reference");
+        }
+      }
+
+      if(cache)
+      {
+        cache->store(cacheKey, { result.report, result.finalEquity, result.equityCurve });
+      }
+
+      printResults(initialCash, result.finalEquity, result.report);
+      if(reportAllocs)
+      {
+        std::cout << "Heap allocations (all threads):\n";
+        writeAllocReport(std::cout, AllocTracker::processStats());
+      }
+      return 0;
+    }
+
+    if(mode == "sweep")
+    {
+      // One run per point of the strategy's parameter grid; see SweepRunner.
+      if(symbols.size() != 1 || !checkpointPath.empty())
+      {
+        throw std::runtime_error("Sweep mode supports one asset and no checkpoint");
+      }
+
+      // Thousands of runs: strategy chatter is off unless asked for.
+      if(!cfg.contains("log_level"))
+      {
+        Log::setLevel(LogLevel::Warn);
+      }
+
+      SweepRunner sweep(std::move(data.series.front()), stratCfg, initialCash, precision,
+                        [&] { return createExecutionEngine(engineCfg); });
+      std::cout << "  Runs:     " << sweep.size() << "\n";
 
-    BacktestEngine engine(std::move(strategy),
-                          std::move(exec),
-                          std::move(feed),
-                          initialCash);
+      std::vector<SweepResult> results = sweep.run(engineCfg.value("threads", std::size_t{ 0 }));
+      std::stable_sort(results.begin(), results.end(),
+                       [](const SweepResult &a, const SweepResult &b)
+                       { return a.report.sharpe > b.report.sharpe; });
+
+      Log::flush();
+      std::size_t top = std::min(results.size(), engineCfg.value("top", std::size_t{ 10 }));
+      std::cout << "\n===== Sweep Results (top " << top << " by Sharpe) =====\n";
+      for(std::size_t i = 0; i < top; ++i)
+      {
+        const SweepResult &res = results[i];
+        std::cout << res.params.dump()
+                  << "  return " << res.report.totalReturn * 100.0 << "%"
+                  << "  sharpe " << res.report.sharpe
+                  << "  max dd " << res.report.maxDrawdown * 100.0 << "%"
+                  << "  trades " << res.trades << "\n";
+      }
+
+      if(reportAllocs)
+      {
+        AllocStats total;
+        for(const auto &res : results)
+        {
+          total += res.allocs;
+        }
+        std::cout << "Heap allocations (all runs):\n";
+        writeAllocReport(std::cout, total);
+      }
+      return 0;
+    }
+
+    std::unique_ptr<BacktestEngine> enginePtr = buildEngine(cfg, data);
+    BacktestEngine &engine = *enginePtr;
+    engine.setPerfCounters(perfMode);
+
+    // Trade ledger: spills to disk past the memory limit when a path is set.
+    if(cfg.contains("trade_ledger"))
+    {
+      const auto &ledgerCfg = cfg.at("trade_ledger");
+      std::size_t limitMb = ledgerCfg.value("memory_limit_mb", std::size_t{ 64 });
+      engine.configureLedger(limitMb << 20, ledgerCfg.value("spill_path", std::string{}));
+    }
+
+    // Optional checkpoint: resume from it when present, refresh it after
+    // the run so the next invocation only simulates newly appended bars.
+    if(!checkpointPath.empty())
+    {
+      engine.setCheckpointIdentity(
+        checkpointIdentity(symbols, stratCfg, engineCfg, initialCash));
+      std::ifstream ckptIn(checkpointPath, std::ios::binary);
+      if(ckptIn)
+      {
+        engine.loadCheckpoint(ckptIn);
+        std::cout << "  Resuming from checkpoint " << checkpointPath
+                  << " (" << engine.barsProcessed() << " bars already processed)\n";
+      }
+    }
 
     Report r = engine.run();
 
+    if(!checkpointPath.empty())
+    {
+      // Written aside and renamed over the old checkpoint, so a crash
+      // mid-write leaves the previous one intact.
+      const std::string tmp = uniqueTempPath(checkpointPath);
+      {
+        std::ofstream ckptOut(tmp, std::ios::binary | std::ios::trunc);
+        if(!ckptOut)
+        {
+          throw std::runtime_error("Failed to open checkpoint file: " + tmp);
+        }
+        engine.saveCheckpoint(ckptOut);
+        ckptOut.close();
+        if(!ckptOut)
+        {
+          std::filesystem::remove(tmp);
+          throw std::runtime_error("Failed to write checkpoint file: " + tmp);
+        }
+      }
+      std::filesystem::rename(tmp, checkpointPath);
+    }
+
     double finalEquity = engine.portfolio().getEquity();
 
-    std::cout << "\n===== Backtest Results =====\n";
-    std::cout << "Initial equity: " << initialCash << "\n";
-    std::cout << "Final equity:   " << finalEquity << "\n";
-    std::cout << "Total return:   " << r.totalReturn * 100.0 << "%\n";
-    std::cout << "CAGR:           " << r.cagr * 100.0 << "%\n";
-    std::cout << "Sharpe:         " << r.sharpe << "\n";
-    std::cout << "Max drawdown:   " << r.maxDrawdown * 100.0 << "%\n";
+    if(cache)
+    {
+      const auto &curve = engine.metrics().snapshots();
+      cache->store(cacheKey, { r, finalEquity, { curve.begin(), curve.end() } });
+    }
+
+    printResults(initialCash, finalEquity, r);
+
+    const TradeLedger &ledger = engine.ledger();
+    std::cout << "Trades:         " << ledger.size() << "\n";
+    if(symbols.size() > 1)
+    {
+      for(const auto &s : ledger.pnlBySymbol())
+      {
+        std::cout << "  " << s.symbol << ": " << s.trades << " trades, realized PnL "
+                  << s.realizedPnL << "\n";
+      }
+    }
+
+    if(reportAllocs)
+    {
+      std::cout << "Heap allocations (engine thread):\n";
+      writeAllocReport(std::cout, engine.allocStats());
+    }
+
+    if(perfMode != PerfMode::Off)
+    {
+      writePerfReport(std::cout, engine.perfReport());
+    }
 
     return 0;
   }
   catch(const std::exception &ex)
   {
+    Log::flush();
     std::cerr << "ERROR: " << ex.what() << "\n";
     return 1;
   }
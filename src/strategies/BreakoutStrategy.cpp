@@ -1,17 +1,23 @@
 #include "Strategy_I.hpp"
 #include "BacktestEngine.hpp"
-#include <vector>
-#include <iostream>
+#include "Checkpoint.hpp"
+#include "Log.hpp"
+#include "RollingWindow.hpp"
 #include <memory>
+#include <memory_resource>
 #include <utility>
 
 class BreakoutStrategy : public Strategy_I
 {
 public:
   BreakoutStrategy(std::string symbol,
-                   std::size_t lookbackWindow)
+                   std::size_t lookbackWindow,
+                   std::pmr::memory_resource *resource)
     : symbol_(std::move(symbol)),
       lookbackWindow_(lookbackWindow),
+      highs_(lookbackWindow + 1, resource),
+      lows_(lookbackWindow + 1, resource),
+      closes_(lookbackWindow + 1, resource),
       trades_(0)
   {
   }
@@ -23,7 +29,7 @@ public:
     lows_.clear();
     closes_.clear();
     trades_ = 0;
-    std::cout << "BreakoutStrategy starting\n";
+    BACKTEST_LOG(Info, "BreakoutStrategy starting");
   }
 
   void onBar(std::size_t /*index*/,
@@ -65,9 +71,35 @@ public:
 
   void onEnd(BacktestEngine &engine) override
   {
-    std::cout << "BreakoutStrategy finished. Final cash: "
-              << engine.portfolio().getCash() << "\n";
-    std::cout << "Breakout trades taken: " << trades_ << "\n";
+    BACKTEST_LOG(Info, "BreakoutStrategy finished. Final cash: {}", engine.portfolio().getCash());
+    BACKTEST_LOG(Info, "Breakout trades taken: {}", trades_);
+  }
+
+  // Signals only look at the last lookbackWindow + 1 bars.
+  std::size_t warmupBars() const override
+  {
+    return lookbackWindow_ + 1;
+  }
+
+  BarFields barFields() const override
+  {
+    return BarField::High | BarField::Low | BarField::Close;
+  }
+
+  void saveState(CheckpointWriter &out) const override
+  {
+    out.writeDoubles(highs_);
+    out.writeDoubles(lows_);
+    out.writeDoubles(closes_);
+    out.writeI64(trades_);
+  }
+
+  void loadState(CheckpointReader &in) override
+  {
+    in.readDoubles(highs_);
+    in.readDoubles(lows_);
+    in.readDoubles(closes_);
+    trades_ = static_cast<int>(in.readI64());
   }
 
 private:
@@ -130,15 +162,17 @@ private:
 
   std::string symbol_;
   std::size_t lookbackWindow_;
-  std::vector<double> highs_;
-  std::vector<double> lows_;
-  std::vector<double> closes_;
+  // Only the last lookbackWindow + 1 bars are kept.
+  RollingWindow<double> highs_;
+  RollingWindow<double> lows_;
+  RollingWindow<double> closes_;
   int trades_;
 };
 
 std::unique_ptr<Strategy_I>
 makeBreakoutStrategy(const std::string &symbol,
-                     std::size_t lookbackWindow)
+                     std::size_t lookbackWindow,
+                     std::pmr::memory_resource *resource)
 {
-  return std::make_unique<BreakoutStrategy>(symbol, lookbackWindow);
+  return std::make_unique<BreakoutStrategy>(symbol, lookbackWindow, resource);
 }
@@ -0,0 +1,130 @@
+#include "CrossSectionalStrategy_I.hpp"
+#include "BacktestEngine.hpp"
+#include "Log.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+/*
+ CROSS-SECTIONAL MOMENTUM RANK STRATEGY
+ --------------------------------------
+ Once per timestamp, ranks every symbol in the universe by its return
+ over the last `lookback` slices and holds the `top_n` strongest names.
+
+ Signals:
+   • Target an equal weight of 1/top_n of equity in each top_n name
+   • Target zero in every other name
+
+ Notes:
+   • Needs the cross-sectional engine mode ("engine": {"mode": "cross_sectional"}).
+   • Closes are kept in a ring of lookback+1 SoA rows, one column per symbol.
+   • Trades come from BacktestEngine::rebalance, so lot size and minimum
+     trade value follow the engine settings.
+*/
+
+class MomentumRankStrategy : public CrossSectionalStrategy_I
+{
+public:
+  MomentumRankStrategy(std::size_t universeSize,
+                       std::size_t lookback,
+                       std::size_t topN,
+                       std::pmr::memory_resource *resource)
+    : universeSize_(universeSize),
+      lookback_(lookback),
+      topN_(topN),
+      history_(resource),
+      observed_(resource),
+      momentum_(resource),
+      candidates_(resource),
+      weights_(resource)
+  {
+  }
+
+  void onStart(BacktestEngine &) override
+  {
+    history_.assign((lookback_ + 1) * universeSize_, 0.0);
+    observed_.assign(universeSize_, 0);
+    momentum_.assign(universeSize_, 0.0);
+    candidates_.clear();
+    candidates_.reserve(universeSize_);
+    weights_.assign(universeSize_, 0.0);
+    row_ = 0;
+    BACKTEST_LOG(Info, "MomentumRankStrategy starting");
+  }
+
+  void onSlice(std::size_t,
+               const UniverseView &view,
+               BacktestEngine &engine) override
+  {
+    const std::size_t n = std::min(view.size, universeSize_);
+    const std::size_t rows = lookback_ + 1;
+    double *current = &history_[row_ * universeSize_];
+    const double *past = &history_[((row_ + 1) % rows) * universeSize_];
+
+    candidates_.clear();
+    for(std::size_t i = 0; i < n; ++i)
+    {
+      current[i] = view.close[i];
+      observed_[i] += view.valid[i];
+      if(view.valid[i] && observed_[i] > lookback_ && past[i] > 0.0)
+      {
+        momentum_[i] = current[i] / past[i] - 1.0;
+        candidates_.push_back(i);
+      }
+    }
+    row_ = (row_ + 1) % rows;
+
+    if(candidates_.empty())
+    {
+      return;
+    }
+
+    const std::size_t keep = std::min(topN_, candidates_.size());
+    std::nth_element(candidates_.begin(),
+                     candidates_.begin() + static_cast<std::ptrdiff_t>(keep - 1),
+                     candidates_.end(),
+                     [this](std::size_t a, std::size_t b)
+                     { return momentum_[a] > momentum_[b]; });
+
+    std::fill(weights_.begin(), weights_.end(), 0.0);
+    const double weight = 1.0 / static_cast<double>(topN_);
+    for(std::size_t k = 0; k < keep; ++k)
+    {
+      weights_[candidates_[k]] = weight;
+    }
+
+    engine.rebalance(weights_.data(), weights_.size());
+  }
+
+  void onEnd(BacktestEngine &engine) override
+  {
+    BACKTEST_LOG(Info, "MomentumRankStrategy finished. Final equity: {}",
+                 engine.portfolio().getEquity());
+  }
+
+  BarFields barFields() const override { return BarField::Close; }
+
+private:
+  std::size_t universeSize_;
+  std::size_t lookback_;
+  std::size_t topN_;
+
+  std::pmr::vector<double> history_;
+  std::pmr::vector<std::size_t> observed_;
+  std::pmr::vector<double> momentum_;
+  std::pmr::vector<std::size_t> candidates_;
+  std::pmr::vector<double> weights_;
+  std::size_t row_{};
+};
+
+std::unique_ptr<CrossSectionalStrategy_I>
+makeMomentumRankStrategy(std::size_t universeSize,
+                         std::size_t lookback,
+                         std::size_t topN,
+                         std::pmr::memory_resource *resource)
+{
+  return std::make_unique<MomentumRankStrategy>(universeSize, lookback, topN, resource);
+}
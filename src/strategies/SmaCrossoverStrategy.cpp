@@ -1,24 +1,29 @@
 #include "Strategy_I.hpp"
 #include "BacktestEngine.hpp"
-#include <deque>
-#include <iostream>
+#include "Checkpoint.hpp"
+#include "Log.hpp"
+#include "RollingWindow.hpp"
+#include <algorithm>
 #include <memory>
+#include <memory_resource>
 
 class SmaCrossoverStrategy : public Strategy_I
 {
 public:
   SmaCrossoverStrategy(std::string symbol,
                        int shortPeriod,
-                       int longPeriod)
+                       int longPeriod,
+                       std::pmr::memory_resource *resource)
     : symbol_(std::move(symbol)),
       shortPeriod_(shortPeriod),
-      longPeriod_(longPeriod) {}
+      longPeriod_(longPeriod),
+      closes_(static_cast<std::size_t>(std::max(longPeriod, 1)), resource) {}
 
   void onStart(BacktestEngine &engine) override
   {
     (void)engine;
     closes_.clear();
-    std::cout << "SmaCrossoverStrategy starting\n";
+    BACKTEST_LOG(Info, "SmaCrossoverStrategy starting");
   }
 
   void onBar(std::size_t /*index*/,
@@ -31,10 +36,6 @@ public:
     }
 
     closes_.push_back(bar.close);
-    while((int)closes_.size() > longPeriod_)
-    {
-      closes_.pop_front();
-    }
     if((int)closes_.size() < longPeriod_)
     {
       return;
@@ -66,8 +67,25 @@ public:
 
   void onEnd(BacktestEngine &engine) override
   {
-    std::cout << "SmaCrossoverStrategy finished. Final equity: "
-              << engine.portfolio().getEquity() << "\n";
+    BACKTEST_LOG(Info, "SmaCrossoverStrategy finished. Final equity: {}",
+                 engine.portfolio().getEquity());
+  }
+
+  std::size_t warmupBars() const override
+  {
+    return static_cast<std::size_t>(longPeriod_);
+  }
+
+  BarFields barFields() const override { return BarField::Close; }
+
+  void saveState(CheckpointWriter &out) const override
+  {
+    out.writeDoubles(closes_);
+  }
+
+  void loadState(CheckpointReader &in) override
+  {
+    in.readDoubles(closes_);
   }
 
 private:
@@ -90,14 +108,15 @@ private:
   std::string symbol_;
   int shortPeriod_;
   int longPeriod_;
-  std::deque<double> closes_;
+  RollingWindow<double> closes_; // last longPeriod closes
 };
 
 std::unique_ptr<Strategy_I>
 makeSmaCrossoverStrategy(const std::string &symbol,
                          int shortPeriod,
-                         int longPeriod)
+                         int longPeriod,
+                         std::pmr::memory_resource *resource)
 {
   return std::make_unique<SmaCrossoverStrategy>(
-    symbol, shortPeriod, longPeriod);
+    symbol, shortPeriod, longPeriod, resource);
 }
@@ -1,9 +1,12 @@
 #include "Strategy_I.hpp"
 #include "BacktestEngine.hpp"
-#include <deque>
+#include "Checkpoint.hpp"
+#include "Log.hpp"
+#include "RollingWindow.hpp"
+#include <algorithm>
 #include <cmath>
-#include <iostream>
 #include <memory>
+#include <memory_resource>
 
 class TrendRsiStrategy : public Strategy_I
 {
@@ -12,18 +15,20 @@ public:
                    int period,
                    double overbought,
                    double oversold,
-                   int trendWindow)
+                   int trendWindow,
+                   std::pmr::memory_resource *resource)
     : symbol_(std::move(symbol)),
       period_(period),
       overbought_(overbought),
       oversold_(oversold),
-      trendWindow_(trendWindow) {}
+      trendWindow_(trendWindow),
+      closes_(static_cast<std::size_t>(std::max({ period + 1, trendWindow, 1 })), resource) {}
 
   void onStart(BacktestEngine &engine) override
   {
     (void)engine;
     closes_.clear();
-    std::cout << "TrendRsiStrategy starting\n";
+    BACKTEST_LOG(Info, "TrendRsiStrategy starting");
   }
 
   void onBar(std::size_t /*index*/,
@@ -41,10 +46,6 @@ public:
     const int maxNeededInt = std::max(period_ + 1, trendWindow_);
     const std::size_t maxNeeded = static_cast<std::size_t>(maxNeededInt);
 
-    while(closes_.size() > maxNeeded)
-    {
-      closes_.pop_front();
-    }
     if(closes_.size() < maxNeeded)
     {
       return;
@@ -77,8 +78,25 @@ public:
 
   void onEnd(BacktestEngine &engine) override
   {
-    std::cout << "TrendRsiStrategy finished. Final equity: "
-              << engine.portfolio().getEquity() << "\n";
+    BACKTEST_LOG(Info, "TrendRsiStrategy finished. Final equity: {}",
+                 engine.portfolio().getEquity());
+  }
+
+  std::size_t warmupBars() const override
+  {
+    return static_cast<std::size_t>(std::max(period_ + 1, trendWindow_));
+  }
+
+  BarFields barFields() const override { return BarField::Close; }
+
+  void saveState(CheckpointWriter &out) const override
+  {
+    out.writeDoubles(closes_);
+  }
+
+  void loadState(CheckpointReader &in) override
+  {
+    in.readDoubles(closes_);
   }
 
 private:
@@ -146,7 +164,7 @@ private:
   double overbought_;
   double oversold_;
   int trendWindow_;
-  std::deque<double> closes_;
+  RollingWindow<double> closes_; // last max(period + 1, trendWindow) closes
 };
 
 std::unique_ptr<Strategy_I>
@@ -154,8 +172,9 @@ makeTrendRsiStrategy(const std::string &symbol,
                      int period,
                      double overbought,
                      double oversold,
-                     int trendWindow)
+                     int trendWindow,
+                     std::pmr::memory_resource *resource)
 {
   return std::make_unique<TrendRsiStrategy>(
-    symbol, period, overbought, oversold, trendWindow);
+    symbol, period, overbought, oversold, trendWindow, resource);
 }
@@ -1,9 +1,12 @@
 #include "Strategy_I.hpp"
 #include "BacktestEngine.hpp"
-#include <deque>
+#include "Checkpoint.hpp"
+#include "Log.hpp"
+#include "RollingWindow.hpp"
+#include <algorithm>
 #include <cmath>
-#include <iostream>
 #include <memory>
+#include <memory_resource>
 
 /*
  Z-SCORE MEAN REVERSION STRATEGY
@@ -30,18 +33,20 @@ public:
   ZScoreMeanReversion(std::string symbol,
                       int zWindow,
                       double zEntry,
-                      double zExit)
+                      double zExit,
+                      std::pmr::memory_resource *resource)
     : symbol_(std::move(symbol)),
       zWindow_(zWindow),
       zEntry_(zEntry),
-      zExit_(zExit)
+      zExit_(zExit),
+      closes_(static_cast<std::size_t>(std::max(zWindow, 1)), resource)
   {
   }
 
   void onStart(BacktestEngine &) override
   {
     closes_.clear();
-    std::cout << "ZScoreMeanReversionStrategy starting\n";
+    BACKTEST_LOG(Info, "ZScoreMeanReversionStrategy starting");
   }
 
   void onBar(std::size_t,
@@ -55,11 +60,6 @@ public:
 
     closes_.push_back(bar.close);
 
-    while(closes_.size() > static_cast<std::size_t>(zWindow_))
-    {
-      closes_.pop_front();
-    }
-
     if(closes_.size() < static_cast<std::size_t>(zWindow_))
     {
       return;
@@ -91,8 +91,25 @@ public:
 
   void onEnd(BacktestEngine &engine) override
   {
-    std::cout << "ZScoreMeanReversion finished. Final equity: "
-              << engine.portfolio().getEquity() << "\n";
+    BACKTEST_LOG(Info, "ZScoreMeanReversion finished. Final equity: {}",
+                 engine.portfolio().getEquity());
+  }
+
+  std::size_t warmupBars() const override
+  {
+    return static_cast<std::size_t>(zWindow_);
+  }
+
+  BarFields barFields() const override { return BarField::Close; }
+
+  void saveState(CheckpointWriter &out) const override
+  {
+    out.writeDoubles(closes_);
+  }
+
+  void loadState(CheckpointReader &in) override
+  {
+    in.readDoubles(closes_);
   }
 
 private:
@@ -134,18 +151,20 @@ private:
   int zWindow_;
   double zEntry_;
   double zExit_;
-  std::deque<double> closes_;
+  RollingWindow<double> closes_; // last zWindow closes
 };
 
 std::unique_ptr<Strategy_I>
 makeZScoreMeanReversionStrategy(const std::string &symbol,
                                 int zWindow,
                                 double zEntry,
-                                double zExit)
+                                double zExit,
+                                std::pmr::memory_resource *resource)
 {
   return std::make_unique<ZScoreMeanReversion>(
     symbol,
     zWindow,
     zEntry,
-    zExit);
+    zExit,
+    resource);
 }
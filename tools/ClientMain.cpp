@@ -0,0 +1,223 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Test client for `backtest_engine --serve`: sends run configs as jobs
+// and prints the responses, or measures round-trip latency.
+
+using nlohmann::json;
+
+namespace
+{
+
+void usage()
+{
+  std::cerr << "usage: backtest_client <socket> [--repeat N] [config.json...]\n\n"
+               "  Sends each config as one job (stdin lines when none are given) and\n"
+               "  prints the responses as they arrive.\n"
+               "  --repeat N  send the first job N times, one at a time, and report\n"
+               "              round-trip latency instead\n";
+}
+
+class Client
+{
+public:
+  explicit Client(const std::string &socketPath)
+  {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if(socketPath.size() >= sizeof(address.sun_path))
+    {
+      throw std::runtime_error("Socket path too long: " + socketPath);
+    }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd_ < 0
+       || ::connect(fd_, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0)
+    {
+      throw std::runtime_error("Cannot connect to " + socketPath + ": " + std::strerror(errno));
+    }
+  }
+
+  ~Client() { ::close(fd_); }
+
+  Client(const Client &) = delete;
+  Client &operator=(const Client &) = delete;
+
+  void send(const std::string &line)
+  {
+    std::size_t sent = 0;
+    while(sent < line.size())
+    {
+      ssize_t n = ::send(fd_, line.data() + sent, line.size() - sent, MSG_NOSIGNAL);
+      if(n <= 0)
+      {
+        throw std::runtime_error("Server closed the connection");
+      }
+      sent += static_cast<std::size_t>(n);
+    }
+  }
+
+  void finishSending() { ::shutdown(fd_, SHUT_WR); }
+
+  // Next response line; false once the server has closed the connection.
+  bool receive(std::string &line)
+  {
+    for(;;)
+    {
+      std::size_t end = pending_.find('\n');
+      if(end != std::string::npos)
+      {
+        line = pending_.substr(0, end);
+        pending_.erase(0, end + 1);
+        return true;
+      }
+
+      char buffer[1 << 16];
+      ssize_t n = ::recv(fd_, buffer, sizeof(buffer), 0);
+      if(n <= 0)
+      {
+        return false;
+      }
+      pending_.append(buffer, static_cast<std::size_t>(n));
+    }
+  }
+
+private:
+  int fd_{ -1 };
+  std::string pending_;
+};
+
+json loadJob(const std::string &path)
+{
+  std::ifstream in(path);
+  if(!in)
+  {
+    throw std::runtime_error("Failed to open config file: " + path);
+  }
+  json job;
+  in >> job;
+  return job;
+}
+
+int measureLatency(Client &client, json job, std::size_t repeat)
+{
+  job["id"] = 0;
+  const std::string line = job.dump() + "\n";
+
+  std::vector<double> micros;
+  std::string response;
+  for(std::size_t i = 0; i < repeat; ++i)
+  {
+    auto start = std::chrono::steady_clock::now();
+    client.send(line);
+    if(!client.receive(response))
+    {
+      throw std::runtime_error("Server closed the connection");
+    }
+    micros.push_back(std::chrono::duration<double, std::micro>(
+                       std::chrono::steady_clock::now() - start)
+                       .count());
+
+    if(i == 0)
+    {
+      std::cout << response << "\n";
+    }
+  }
+
+  std::sort(micros.begin(), micros.end());
+  auto at = [&](double q)
+  { return micros[static_cast<std::size_t>(q * static_cast<double>(micros.size() - 1))]; };
+  std::cout << "round trips:  " << micros.size() << "\n"
+            << "min:          " << micros.front() << " us\n"
+            << "p50:          " << at(0.5) << " us\n"
+            << "p99:          " << at(0.99) << " us\n"
+            << "max:          " << micros.back() << " us\n";
+  return 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+  if(argc < 2)
+  {
+    usage();
+    return 1;
+  }
+
+  try
+  {
+    std::size_t repeat = 0;
+    std::vector<json> jobs;
+    for(int i = 2; i < argc; ++i)
+    {
+      if(std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+      {
+        repeat = std::stoul(argv[++i]);
+      }
+      else
+      {
+        jobs.push_back(loadJob(argv[i]));
+      }
+    }
+    if(jobs.empty())
+    {
+      for(std::string line; std::getline(std::cin, line);)
+      {
+        if(!line.empty())
+        {
+          jobs.push_back(json::parse(line));
+        }
+      }
+    }
+    if(jobs.empty())
+    {
+      usage();
+      return 1;
+    }
+
+    Client client(argv[1]);
+    if(repeat > 0)
+    {
+      return measureLatency(client, jobs.front(), repeat);
+    }
+
+    for(std::size_t i = 0; i < jobs.size(); ++i)
+    {
+      if(!jobs[i].contains("id"))
+      {
+        jobs[i]["id"] = i;
+      }
+      client.send(jobs[i].dump() + "\n");
+    }
+    client.finishSending();
+
+    std::size_t failed = 0;
+    std::string response;
+    for(std::size_t received = 0; received < jobs.size() && client.receive(response); ++received)
+    {
+      std::cout << response << "\n";
+      failed += json::parse(response).value("status", std::string{}) != "ok";
+    }
+    return failed == 0 ? 0 : 1;
+  }
+  catch(const std::exception &ex)
+  {
+    std::cerr << "ERROR: " << ex.what() << "\n";
+    return 1;
+  }
+}
@@ -0,0 +1,449 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "ColumnarStore.hpp"
+#include "Timestamp.hpp"
+#include "feed/AlphaVantageFeed.hpp"
+
+// Bulk importer: converts a directory of per-symbol JSON/CSV dumps into a
+// sharded columnar dataset (see ColumnarStore.hpp) in parallel.
+
+using nlohmann::json;
+namespace fs = std::filesystem;
+
+namespace
+{
+
+void usage()
+{
+  std::cerr << "usage: backtest_import <input-dir> <output-dir> [--threads N]"
+               " [--chunk-rows N] [--raw]\n\n"
+               "  Parses every .csv and .json file under <input-dir> (one symbol per\n"
+               "  file, named after the file) and writes one shard per thread plus\n"
+               "  manifest.json to <output-dir>.\n"
+               "  CSV needs a header with timestamp (or date), open, high, low, close\n"
+               "  and volume columns. JSON may be an Alpha Vantage TIME_SERIES_DAILY\n"
+               "  response or an array of objects with the same fields.\n"
+               "  Bars are stored in chunks of --chunk-rows rows (default 1024), the\n"
+               "  unit a time-range read skips over. Columns are compressed losslessly\n"
+               "  (fixed-point, delta, bit-packed) unless --raw is given.\n";
+}
+
+struct FileStats
+{
+  std::uint64_t bytes{};
+  std::uint64_t rows{};
+  std::uint64_t duplicates{};
+  bool resorted{};
+};
+
+std::string readFile(const fs::path &path)
+{
+  std::ifstream in(path, std::ios::binary);
+  if(!in)
+  {
+    throw std::runtime_error("cannot open");
+  }
+  std::ostringstream buffer;
+  buffer << in.rdbuf();
+  return buffer.str();
+}
+
+std::string lower(std::string s)
+{
+  std::transform(s.begin(), s.end(), s.begin(),
+                 [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+  return s;
+}
+
+double parseNumber(std::string_view field)
+{
+  while(!field.empty() && (field.front() == ' ' || field.front() == '"'))
+  {
+    field.remove_prefix(1);
+  }
+  while(!field.empty() && (field.back() == ' ' || field.back() == '"' || field.back() == '\r'))
+  {
+    field.remove_suffix(1);
+  }
+
+  double v = 0.0;
+  auto [end, ec] = std::from_chars(field.data(), field.data() + field.size(), v);
+  if(ec != std::errc{} || end != field.data() + field.size())
+  {
+    throw std::runtime_error("bad number '" + std::string(field) + "'");
+  }
+  return v;
+}
+
+void push(BarColumns &bars, std::int64_t time, double open, double high, double low,
+          double close, double volume)
+{
+  bars.time.push_back(time);
+  bars.open.push_back(open);
+  bars.high.push_back(high);
+  bars.low.push_back(low);
+  bars.close.push_back(close);
+  bars.volume.push_back(volume);
+}
+
+void parseCsv(const std::string &text, BarColumns &bars)
+{
+  std::vector<std::string_view> fields;
+  auto split = [&](std::string_view line)
+  {
+    fields.clear();
+    std::size_t start = 0;
+    for(;;)
+    {
+      std::size_t comma = line.find(',', start);
+      fields.push_back(line.substr(start, comma - start));
+      if(comma == std::string_view::npos)
+      {
+        break;
+      }
+      start = comma + 1;
+    }
+  };
+
+  std::string_view rest(text);
+  auto nextLine = [&](std::string_view &line)
+  {
+    while(!rest.empty())
+    {
+      std::size_t end = rest.find('\n');
+      line = rest.substr(0, end);
+      rest.remove_prefix(end == std::string_view::npos ? rest.size() : end + 1);
+      if(!line.empty() && line.back() == '\r')
+      {
+        line.remove_suffix(1);
+      }
+      if(!line.empty())
+      {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  std::string_view line;
+  if(!nextLine(line))
+  {
+    throw std::runtime_error("empty file");
+  }
+
+  // Column positions from the header.
+  split(line);
+  constexpr std::size_t missing = std::string::npos;
+  std::size_t col[6] = { missing, missing, missing, missing, missing, missing };
+  const char *names[6] = { "timestamp", "open", "high", "low", "close", "volume" };
+  for(std::size_t i = 0; i < fields.size(); ++i)
+  {
+    std::string name = lower(std::string(fields[i]));
+    name.erase(std::remove(name.begin(), name.end(), '"'), name.end());
+    if(name == "date" || name == "time" || name == "datetime")
+    {
+      name = "timestamp";
+    }
+    for(std::size_t c = 0; c < 6; ++c)
+    {
+      if(name == names[c] && col[c] == missing)
+      {
+        col[c] = i;
+      }
+    }
+  }
+  for(std::size_t c = 0; c < 6; ++c)
+  {
+    if(col[c] == missing)
+    {
+      throw std::runtime_error(std::string("no '") + names[c] + "' column");
+    }
+  }
+  const std::size_t needed = *std::max_element(std::begin(col), std::end(col)) + 1;
+
+  std::string ts;
+  while(nextLine(line))
+  {
+    split(line);
+    if(fields.size() < needed)
+    {
+      throw std::runtime_error("short row '" + std::string(line) + "'");
+    }
+    ts.assign(fields[col[0]]);
+    ts.erase(std::remove(ts.begin(), ts.end(), '"'), ts.end());
+    push(bars, parseTimestamp(ts), parseNumber(fields[col[1]]), parseNumber(fields[col[2]]),
+         parseNumber(fields[col[3]]), parseNumber(fields[col[4]]), parseNumber(fields[col[5]]));
+  }
+}
+
+void parseJson(const std::string &text, BarColumns &bars)
+{
+  json j = json::parse(text);
+  if(j.is_object() && j.contains("Time Series (Daily)"))
+  {
+    for(const Candle &c : parseAlphaVantageCandles(text, bars.symbol, 0))
+    {
+      push(bars, parseTimestamp(c.timestamp), c.open, c.high, c.low, c.close, c.volume);
+    }
+    return;
+  }
+  if(!j.is_array())
+  {
+    throw std::runtime_error("expected an Alpha Vantage response or an array of bars");
+  }
+
+  auto number = [](const json &v)
+  { return v.is_string() ? parseNumber(v.get<std::string>()) : v.get<double>(); };
+  for(const json &row : j)
+  {
+    const json &ts = row.contains("timestamp") ? row.at("timestamp") : row.at("date");
+    push(bars, parseTimestamp(ts.get<std::string>()), number(row.at("open")),
+         number(row.at("high")), number(row.at("low")), number(row.at("close")),
+         number(row.at("volume")));
+  }
+}
+
+// Sorts by time if needed (dumps are often newest first) and keeps the
+// last row of every timestamp.
+void normalize(BarColumns &bars, FileStats &stats)
+{
+  const std::size_t n = bars.size();
+  if(!std::is_sorted(bars.time.begin(), bars.time.end()))
+  {
+    stats.resorted = true;
+    std::vector<std::size_t> order(n);
+    std::iota(order.begin(), order.end(), std::size_t{ 0 });
+    std::stable_sort(order.begin(), order.end(),
+                     [&](std::size_t a, std::size_t b) { return bars.time[a] < bars.time[b]; });
+
+    BarColumns sorted;
+    sorted.symbol = bars.symbol;
+    for(std::size_t i : order)
+    {
+      push(sorted, bars.time[i], bars.open[i], bars.high[i], bars.low[i], bars.close[i],
+           bars.volume[i]);
+    }
+    bars = std::move(sorted);
+  }
+
+  std::size_t out = 0;
+  for(std::size_t i = 0; i < n; ++i)
+  {
+    if(i + 1 < n && bars.time[i + 1] == bars.time[i])
+    {
+      ++stats.duplicates;
+      continue;
+    }
+    bars.time[out] = bars.time[i];
+    bars.open[out] = bars.open[i];
+    bars.high[out] = bars.high[i];
+    bars.low[out] = bars.low[i];
+    bars.close[out] = bars.close[i];
+    bars.volume[out] = bars.volume[i];
+    ++out;
+  }
+  for(auto *column : { &bars.open, &bars.high, &bars.low, &bars.close, &bars.volume })
+  {
+    column->resize(out);
+  }
+  bars.time.resize(out);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+  if(argc < 3)
+  {
+    usage();
+    return 1;
+  }
+
+  try
+  {
+    const fs::path inputDir = argv[1];
+    const fs::path outputDir = argv[2];
+    std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    std::size_t chunkRows = ColumnarShardWriter::defaultChunkRows;
+    ColumnEncoding encoding = ColumnEncoding::Packed;
+    for(int i = 3; i < argc; ++i)
+    {
+      if(std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+      {
+        threads = std::max<std::size_t>(1, std::stoul(argv[++i]));
+      }
+      else if(std::strcmp(argv[i], "--chunk-rows") == 0 && i + 1 < argc)
+      {
+        chunkRows = std::max<std::size_t>(1, std::stoul(argv[++i]));
+      }
+      else if(std::strcmp(argv[i], "--raw") == 0)
+      {
+        encoding = ColumnEncoding::Raw;
+      }
+      else
+      {
+        usage();
+        return 1;
+      }
+    }
+
+    std::vector<fs::path> files;
+    for(const auto &entry : fs::recursive_directory_iterator(inputDir))
+    {
+      const std::string ext = lower(entry.path().extension().string());
+      if(entry.is_regular_file() && (ext == ".csv" || ext == ".json"))
+      {
+        files.push_back(entry.path());
+      }
+    }
+    if(files.empty())
+    {
+      throw std::runtime_error("No .csv or .json files under " + inputDir.string());
+    }
+    // Largest first, so no thread is left with a big file at the end.
+    std::sort(files.begin(), files.end(), [](const fs::path &a, const fs::path &b)
+              { return fs::file_size(a) > fs::file_size(b); });
+    threads = std::min(threads, files.size());
+
+    fs::create_directories(outputDir);
+    std::cout << "Importing " << files.size() << " files from " << inputDir.string()
+              << " with " << threads << " thread(s)\n";
+
+    // One shard per worker: each thread appends the symbols it parsed.
+    std::atomic<std::size_t> nextFile{ 0 };
+    std::vector<std::vector<ColumnarManifestEntry>> entries(threads);
+    std::vector<FileStats> totals(threads);
+    std::vector<std::size_t> resorted(threads);
+    std::vector<std::uint64_t> shardBytes(threads);
+    std::mutex errorsMutex;
+    std::vector<std::string> errors;
+
+    auto start = std::chrono::steady_clock::now();
+    auto work = [&](std::size_t w)
+    {
+      char name[32];
+      std::snprintf(name, sizeof(name), "shard-%04zu.cols", w);
+      ColumnarShardWriter shard((outputDir / name).string(), chunkRows, encoding);
+
+      for(std::size_t i = nextFile++; i < files.size(); i = nextFile++)
+      {
+        const fs::path &path = files[i];
+        try
+        {
+          std::string text = readFile(path);
+          BarColumns bars;
+          bars.symbol = path.stem().string();
+          if(lower(path.extension().string()) == ".csv")
+          {
+            parseCsv(text, bars);
+          }
+          else
+          {
+            parseJson(text, bars);
+          }
+          if(bars.size() == 0)
+          {
+            throw std::runtime_error("no bars");
+          }
+
+          FileStats stats;
+          stats.bytes = text.size();
+          normalize(bars, stats);
+          stats.rows = bars.size();
+          shard.write(bars);
+
+          entries[w].push_back({ bars.symbol, name, bars.size(), bars.time.front(),
+                                 bars.time.back() });
+          totals[w].bytes += stats.bytes;
+          totals[w].rows += stats.rows;
+          totals[w].duplicates += stats.duplicates;
+          resorted[w] += stats.resorted ? 1 : 0;
+        }
+        catch(const std::exception &ex)
+        {
+          std::lock_guard<std::mutex> lock(errorsMutex);
+          errors.push_back(path.string() + ": " + ex.what());
+        }
+      }
+      shard.finish();
+      shardBytes[w] = shard.bytesWritten();
+    };
+
+    std::vector<std::thread> pool;
+    for(std::size_t w = 1; w < threads; ++w)
+    {
+      pool.emplace_back(work, w);
+    }
+    work(0);
+    for(auto &t : pool)
+    {
+      t.join();
+    }
+
+    std::vector<ColumnarManifestEntry> manifest;
+    FileStats total;
+    std::size_t totalResorted = 0;
+    std::uint64_t outputBytes = 0;
+    for(std::size_t w = 0; w < threads; ++w)
+    {
+      manifest.insert(manifest.end(), entries[w].begin(), entries[w].end());
+      total.bytes += totals[w].bytes;
+      total.rows += totals[w].rows;
+      total.duplicates += totals[w].duplicates;
+      totalResorted += resorted[w];
+      outputBytes += shardBytes[w];
+    }
+    std::sort(manifest.begin(), manifest.end(),
+              [](const ColumnarManifestEntry &a, const ColumnarManifestEntry &b)
+              { return a.symbol < b.symbol; });
+    for(std::size_t i = 1; i < manifest.size(); ++i)
+    {
+      if(manifest[i].symbol == manifest[i - 1].symbol)
+      {
+        errors.push_back("symbol " + manifest[i].symbol + " comes from more than one file");
+      }
+    }
+    writeColumnarManifest(outputDir.string(), manifest);
+    const double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const double mb = static_cast<double>(total.bytes) / 1e6;
+    std::cout << "Symbols:        " << manifest.size() << "\n"
+              << "Bars:           " << total.rows << "\n"
+              << "Duplicates:     " << total.duplicates << " dropped\n"
+              << "Re-sorted:      " << totalResorted << " file(s)\n"
+              << "Input:          " << mb << " MB in " << seconds << " s ("
+              << mb / seconds << " MB/s)\n"
+              << "Output:         " << static_cast<double>(outputBytes) / 1e6 << " MB in "
+              << threads << " shard(s)\n";
+
+    for(const auto &e : errors)
+    {
+      std::cerr << "ERROR: " << e << "\n";
+    }
+    return errors.empty() ? 0 : 1;
+  }
+  catch(const std::exception &ex)
+  {
+    std::cerr << "ERROR: " << ex.what() << "\n";
+    return 1;
+  }
+}